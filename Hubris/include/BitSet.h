@@ -0,0 +1,246 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <bit>
+#include <algorithm>
+#include "List.h"
+
+#if defined(__AVX2__)
+#define HBR_BITSET_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HBR_BITSET_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace Hubris {
+    /**
+     * @brief A dynamically sized set of bits stored as 64-bit words.
+     *
+     * Iteration over set bits uses count-trailing-zeros, counting uses popcount and the bulk operators (&=, |=, ^=, and_not) process 128/256 bits per instruction.
+     * Bits past size() are always kept at zero.
+     */
+    class BitSet {
+    public:
+        using size_type = std::size_t;
+
+        enum class Result {
+            Success,
+            OutOfMemory
+        };
+
+        static constexpr size_type npos = static_cast<size_type>(-1);
+
+    private:
+        List<uint64_t> m_words;
+        size_type m_bits = 0;
+
+        static constexpr size_type WordCount(size_type bits) noexcept { return (bits + 63) / 64; }
+
+        //Zeroes the bits of the last word that are past m_bits.
+        void trim() noexcept {
+            if (m_bits % 64 && !m_words.empty())
+                m_words.back() &= (uint64_t(1) << (m_bits % 64)) - 1;
+        }
+
+        template<typename Op, typename SimdOp>
+        BitSet& apply(const BitSet& rhs, Op op, [[maybe_unused]] SimdOp simd) noexcept {
+            const size_type n = std::min(m_words.size(), rhs.m_words.size());
+            uint64_t* a = m_words.data();
+            const uint64_t* b = rhs.m_words.data();
+            size_type i = 0;
+#if defined(HBR_BITSET_AVX2)
+            for (; i + 4 <= n; i += 4) {
+                const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+                const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(a + i), simd(va, vb));
+            }
+#elif defined(HBR_BITSET_SSE2)
+            for (; i + 2 <= n; i += 2) {
+                const __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+                const __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(a + i), simd(va, vb));
+            }
+#endif
+            for (; i < n; ++i) a[i] = op(a[i], b[i]);
+            return *this;
+        }
+
+    public:
+        BitSet() noexcept = default;
+
+        explicit BitSet(size_type bits, bool value = false) noexcept {
+            resize(bits, value);
+        }
+
+        /**
+         * @brief Changes the number of bits, new bits take the given value.
+         */
+        Result resize(size_type bits, bool value = false) noexcept {
+            const size_type oldBits = m_bits;
+            if (m_words.resize(WordCount(bits), value ? ~uint64_t(0) : 0) != List<uint64_t>::Result::Success)
+                return Result::OutOfMemory;
+            if (value && bits > oldBits && oldBits % 64) {
+                //Fill the tail of the previously last word.
+                m_words[oldBits / 64] |= ~uint64_t(0) << (oldBits % 64);
+            }
+            m_bits = bits;
+            trim();
+            return Result::Success;
+        }
+
+        size_type size() const noexcept { return m_bits; }
+        bool empty() const noexcept { return m_bits == 0; }
+        size_type word_count() const noexcept { return m_words.size(); }
+        const uint64_t* words() const noexcept { return m_words.data(); }
+        uint64_t* words() noexcept { return m_words.data(); }
+
+        bool test(size_type bit) const noexcept {
+            return (m_words[bit / 64] >> (bit % 64)) & 1;
+        }
+
+        bool operator[](size_type bit) const noexcept { return test(bit); }
+
+        void set(size_type bit) noexcept { m_words[bit / 64] |= uint64_t(1) << (bit % 64); }
+        void reset(size_type bit) noexcept { m_words[bit / 64] &= ~(uint64_t(1) << (bit % 64)); }
+        void flip(size_type bit) noexcept { m_words[bit / 64] ^= uint64_t(1) << (bit % 64); }
+        void assign(size_type bit, bool value) noexcept { value ? set(bit) : reset(bit); }
+
+        /**
+         * @brief Sets every bit.
+         */
+        void set() noexcept {
+            if (!m_words.empty()) std::memset(m_words.data(), 0xFF, m_words.size() * sizeof(uint64_t));
+            trim();
+        }
+
+        /**
+         * @brief Clears every bit, the size is unchanged.
+         */
+        void reset() noexcept {
+            if (!m_words.empty()) std::memset(m_words.data(), 0, m_words.size() * sizeof(uint64_t));
+        }
+
+        /**
+         * @brief Number of set bits.
+         */
+        size_type count() const noexcept {
+            size_type n = 0;
+            for (size_type i = 0; i < m_words.size(); ++i) n += std::popcount(m_words[i]);
+            return n;
+        }
+
+        bool any() const noexcept {
+            for (size_type i = 0; i < m_words.size(); ++i)
+                if (m_words[i]) return true;
+            return false;
+        }
+
+        bool none() const noexcept { return !any(); }
+
+        /**
+         * @return Index of the first set bit, or npos.
+         */
+        size_type find_first() const noexcept {
+            for (size_type i = 0; i < m_words.size(); ++i)
+                if (m_words[i]) return i * 64 + std::countr_zero(m_words[i]);
+            return npos;
+        }
+
+        /**
+         * @return Index of the first set bit after bit, or npos.
+         */
+        size_type find_next(size_type bit) const noexcept {
+            ++bit;
+            if (bit >= m_bits) return npos;
+            size_type w = bit / 64;
+            uint64_t word = m_words[w] & (~uint64_t(0) << (bit % 64));
+            while (true) {
+                if (word) return w * 64 + std::countr_zero(word);
+                if (++w == m_words.size()) return npos;
+                word = m_words[w];
+            }
+        }
+
+        /**
+         * @brief Calls func(index) for every set bit in increasing order. Faster than a find_first/find_next loop.
+         */
+        template<typename F>
+        void for_each_set(F&& func) const {
+            for (size_type w = 0; w < m_words.size(); ++w) {
+                for (uint64_t bits = m_words[w]; bits; bits &= bits - 1)
+                    func(w * 64 + static_cast<size_type>(std::countr_zero(bits)));
+            }
+        }
+
+        /**
+         * @brief Bulk operators, they apply over the common prefix of both sets. Bits of this set past rhs.size() are left unchanged.
+         */
+        BitSet& operator&=(const BitSet& rhs) noexcept {
+#if defined(HBR_BITSET_AVX2)
+            return apply(rhs, [](uint64_t a, uint64_t b) { return a & b; }, [](__m256i a, __m256i b) { return _mm256_and_si256(a, b); });
+#elif defined(HBR_BITSET_SSE2)
+            return apply(rhs, [](uint64_t a, uint64_t b) { return a & b; }, [](__m128i a, __m128i b) { return _mm_and_si128(a, b); });
+#else
+            return apply(rhs, [](uint64_t a, uint64_t b) { return a & b; }, nullptr);
+#endif
+        }
+
+        BitSet& operator|=(const BitSet& rhs) noexcept {
+#if defined(HBR_BITSET_AVX2)
+            apply(rhs, [](uint64_t a, uint64_t b) { return a | b; }, [](__m256i a, __m256i b) { return _mm256_or_si256(a, b); });
+#elif defined(HBR_BITSET_SSE2)
+            apply(rhs, [](uint64_t a, uint64_t b) { return a | b; }, [](__m128i a, __m128i b) { return _mm_or_si128(a, b); });
+#else
+            apply(rhs, [](uint64_t a, uint64_t b) { return a | b; }, nullptr);
+#endif
+            trim();
+            return *this;
+        }
+
+        BitSet& operator^=(const BitSet& rhs) noexcept {
+#if defined(HBR_BITSET_AVX2)
+            apply(rhs, [](uint64_t a, uint64_t b) { return a ^ b; }, [](__m256i a, __m256i b) { return _mm256_xor_si256(a, b); });
+#elif defined(HBR_BITSET_SSE2)
+            apply(rhs, [](uint64_t a, uint64_t b) { return a ^ b; }, [](__m128i a, __m128i b) { return _mm_xor_si128(a, b); });
+#else
+            apply(rhs, [](uint64_t a, uint64_t b) { return a ^ b; }, nullptr);
+#endif
+            trim();
+            return *this;
+        }
+
+        /**
+         * @brief this &= ~rhs, removes the bits set in rhs.
+         */
+        BitSet& and_not(const BitSet& rhs) noexcept {
+#if defined(HBR_BITSET_AVX2)
+            return apply(rhs, [](uint64_t a, uint64_t b) { return a & ~b; }, [](__m256i a, __m256i b) { return _mm256_andnot_si256(b, a); });
+#elif defined(HBR_BITSET_SSE2)
+            return apply(rhs, [](uint64_t a, uint64_t b) { return a & ~b; }, [](__m128i a, __m128i b) { return _mm_andnot_si128(b, a); });
+#else
+            return apply(rhs, [](uint64_t a, uint64_t b) { return a & ~b; }, nullptr);
+#endif
+        }
+
+        /**
+         * @brief Returns true if both sets have a set bit in common, stops at the first match.
+         */
+        bool intersects(const BitSet& rhs) const noexcept {
+            const size_type n = std::min(m_words.size(), rhs.m_words.size());
+            for (size_type i = 0; i < n; ++i)
+                if (m_words[i] & rhs.m_words[i]) return true;
+            return false;
+        }
+
+        bool operator==(const BitSet& rhs) const noexcept {
+            if (m_bits != rhs.m_bits) return false;
+            return m_words.empty() || std::memcmp(m_words.data(), rhs.m_words.data(), m_words.size() * sizeof(uint64_t)) == 0;
+        }
+    };
+
+    inline BitSet operator&(BitSet lhs, const BitSet& rhs) noexcept { return lhs &= rhs; }
+    inline BitSet operator|(BitSet lhs, const BitSet& rhs) noexcept { return lhs |= rhs; }
+    inline BitSet operator^(BitSet lhs, const BitSet& rhs) noexcept { return lhs ^= rhs; }
+}
@@ -0,0 +1,367 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <bit>
+#include <utility>
+#include <iterator>
+#include <type_traits>
+#include "List.h"
+
+namespace Hubris {
+    /**
+     * @brief A chunked container with stable element addresses (a bucket array / colony).
+     *
+     * Elements live in fixed-size chunks that are never reallocated, so pointers to elements stay valid until that element is erased.
+     * Erased slots are tracked in a per-chunk occupancy bitmask and reused by later insertions, chunks with free slots are linked in a freelist.
+     * Iteration visits live elements only, jumping over holes a word at a time.
+     *
+     * Like List<T>, this container does not throw: allocation failures are reported through return values.
+     * @tparam T The type of elements stored.
+     * @tparam ChunkSize Elements per chunk, must be a multiple of 64.
+     */
+    template<typename T, size_t ChunkSize = 64>
+    class Colony {
+    public:
+        using value_type = T;
+        using size_type = std::size_t;
+        using reference = T&;
+        using const_reference = const T&;
+        using pointer = T*;
+        using const_pointer = const T*;
+
+        enum class Result {
+            Success,
+            OutOfMemory,
+            InvalidArgument
+        };
+
+    private:
+        static_assert(ChunkSize > 0 && ChunkSize % 64 == 0, "ChunkSize must be a multiple of 64 (one occupancy word per 64 slots).");
+        static_assert(!std::is_abstract_v<T> && !std::is_reference_v<T>, "Colony stores complete object types only.");
+
+        static constexpr size_type Words = ChunkSize / 64;
+
+        struct Chunk {
+            alignas(T) unsigned char storage[ChunkSize * sizeof(T)];
+            uint64_t occupied[Words] = {};
+            size_type count = 0;
+            //Intrusive links for the list of chunks that have free slots.
+            Chunk* prevFree = nullptr;
+            Chunk* nextFree = nullptr;
+            bool inFreeList = false;
+
+            T* Slot(size_type i) noexcept { return std::launder(reinterpret_cast<T*>(storage) + i); }
+            const T* Slot(size_type i) const noexcept { return std::launder(reinterpret_cast<const T*>(storage) + i); }
+
+            bool Contains(const T* p) const noexcept {
+                const auto addr = reinterpret_cast<uintptr_t>(p);
+                const auto base = reinterpret_cast<uintptr_t>(storage);
+                return addr >= base && addr < base + sizeof(storage);
+            }
+        };
+
+        //Chunks sorted by address, used for pointer to chunk lookup and for iteration.
+        List<Chunk*> m_chunks;
+        Chunk* m_freeHead = nullptr;
+        size_type m_size = 0;
+
+        void link_free(Chunk* c) noexcept {
+            c->prevFree = nullptr;
+            c->nextFree = m_freeHead;
+            if (m_freeHead) m_freeHead->prevFree = c;
+            m_freeHead = c;
+            c->inFreeList = true;
+        }
+
+        void unlink_free(Chunk* c) noexcept {
+            if (c->prevFree) c->prevFree->nextFree = c->nextFree;
+            else m_freeHead = c->nextFree;
+            if (c->nextFree) c->nextFree->prevFree = c->prevFree;
+            c->prevFree = c->nextFree = nullptr;
+            c->inFreeList = false;
+        }
+
+        //Index of the first chunk whose address is not less than c.
+        size_type lower_bound(const void* p) const noexcept {
+            size_type lo = 0, hi = m_chunks.size();
+            while (lo < hi) {
+                const size_type mid = lo + (hi - lo) / 2;
+                if (reinterpret_cast<uintptr_t>(m_chunks[mid]) < reinterpret_cast<uintptr_t>(p)) lo = mid + 1;
+                else hi = mid;
+            }
+            return lo;
+        }
+
+        Chunk* find_chunk(const T* p) const noexcept {
+            size_type i = lower_bound(p);
+            //The owning chunk starts at or before p.
+            if (i < m_chunks.size() && m_chunks[i]->Contains(p)) return m_chunks[i];
+            if (i > 0 && m_chunks[i - 1]->Contains(p)) return m_chunks[i - 1];
+            return nullptr;
+        }
+
+        Chunk* allocate_chunk() noexcept {
+            void* mem = ::operator new(sizeof(Chunk), std::align_val_t{ alignof(Chunk) }, std::nothrow);
+            if (!mem) return nullptr;
+            Chunk* c = new(mem) Chunk();
+            if (m_chunks.insert(lower_bound(c), c) != List<Chunk*>::Result::Success) {
+                free_chunk_memory(c);
+                return nullptr;
+            }
+            link_free(c);
+            return c;
+        }
+
+        static void free_chunk_memory(Chunk* c) noexcept {
+            c->~Chunk();
+            ::operator delete(c, std::align_val_t{ alignof(Chunk) });
+        }
+
+        void destroy_elements(Chunk* c) noexcept {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                for (size_type w = 0; w < Words; ++w) {
+                    for (uint64_t bits = c->occupied[w]; bits; bits &= bits - 1)
+                        c->Slot(w * 64 + std::countr_zero(bits))->~T();
+                }
+            }
+            for (size_type w = 0; w < Words; ++w) c->occupied[w] = 0;
+            c->count = 0;
+        }
+
+    public:
+        /**
+         * @brief Forward iterator over live elements, holes are skipped with a count-trailing-zeros scan of the occupancy words.
+         */
+        template<bool Const>
+        class basic_iterator {
+            friend class Colony;
+            template<bool> friend class basic_iterator;
+            using ChunkPtr = Chunk* const*;
+            ChunkPtr chunk = nullptr;
+            ChunkPtr chunkEnd = nullptr;
+            size_type word = 0;
+            uint64_t bits = 0;      // Remaining live slots of the current word.
+            size_type slot = 0;
+
+            void settle() noexcept {
+                while (chunk != chunkEnd) {
+                    while (true) {
+                        if (bits) {
+                            slot = word * 64 + std::countr_zero(bits);
+                            return;
+                        }
+                        if (++word == Words) break;
+                        bits = (*chunk)->occupied[word];
+                    }
+                    if (++chunk == chunkEnd) return;
+                    word = 0;
+                    bits = (*chunk)->occupied[0];
+                }
+            }
+
+            basic_iterator(ChunkPtr first, ChunkPtr last) noexcept : chunk(first), chunkEnd(last) {
+                if (chunk != chunkEnd) {
+                    bits = (*chunk)->occupied[0];
+                    settle();
+                }
+            }
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = std::conditional_t<Const, const T*, T*>;
+            using reference = std::conditional_t<Const, const T&, T&>;
+
+            basic_iterator() noexcept = default;
+            operator basic_iterator<true>() const noexcept {
+                basic_iterator<true> it;
+                it.chunk = chunk; it.chunkEnd = chunkEnd; it.word = word; it.bits = bits; it.slot = slot;
+                return it;
+            }
+
+            reference operator*() const noexcept { return *(*chunk)->Slot(slot); }
+            pointer operator->() const noexcept { return (*chunk)->Slot(slot); }
+
+            basic_iterator& operator++() noexcept {
+                bits &= bits - 1;
+                settle();
+                return *this;
+            }
+
+            basic_iterator operator++(int) noexcept {
+                basic_iterator tmp = *this;
+                ++*this;
+                return tmp;
+            }
+
+            bool operator==(const basic_iterator& rhs) const noexcept {
+                return chunk == rhs.chunk && (chunk == chunkEnd || slot == rhs.slot);
+            }
+        };
+
+        using iterator = basic_iterator<false>;
+        using const_iterator = basic_iterator<true>;
+
+        Colony() noexcept = default;
+        Colony(const Colony&) = delete;
+        Colony& operator=(const Colony&) = delete;
+
+        Colony(Colony&& other) noexcept
+            : m_chunks(std::move(other.m_chunks)), m_freeHead(std::exchange(other.m_freeHead, nullptr)), m_size(std::exchange(other.m_size, 0)) {}
+
+        Colony& operator=(Colony&& other) noexcept {
+            if (this != &other) {
+                release();
+                m_chunks = std::move(other.m_chunks);
+                m_freeHead = std::exchange(other.m_freeHead, nullptr);
+                m_size = std::exchange(other.m_size, 0);
+            }
+            return *this;
+        }
+
+        ~Colony() {
+            release();
+        }
+
+        /**
+         * @brief Constructs an element in a free slot, reusing erased slots before allocating a new chunk.
+         * @return A pointer to the new element, stable until it is erased. nullptr if a chunk could not be allocated.
+         */
+        template<typename... Args>
+        T* emplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>) {
+            Chunk* c = m_freeHead ? m_freeHead : allocate_chunk();
+            if (!c) return nullptr;
+
+            size_type w = 0;
+            while (c->occupied[w] == ~uint64_t(0)) ++w;
+            const size_type i = w * 64 + std::countr_one(c->occupied[w]);
+
+            T* p = new(c->Slot(i)) T(std::forward<Args>(args)...);
+            c->occupied[w] |= uint64_t(1) << (i % 64);
+            if (++c->count == ChunkSize) unlink_free(c);
+            ++m_size;
+            return p;
+        }
+
+        T* insert(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>) { return emplace(value); }
+        T* insert(T&& value) noexcept(std::is_nothrow_move_constructible_v<T>) { return emplace(std::move(value)); }
+
+        /**
+         * @brief Destroys the element and recycles its slot. Other elements are not moved.
+         *
+         * A chunk that becomes empty is released unless it is the last one with free slots, to avoid thrashing on insert/erase pairs.
+         * @return InvalidArgument if the pointer is not a live element of this container.
+         */
+        Result erase(const T* element) noexcept {
+            Chunk* c = find_chunk(element);
+            if (!c) return Result::InvalidArgument;
+            const size_type i = static_cast<size_type>(element - c->Slot(0));
+            const uint64_t bit = uint64_t(1) << (i % 64);
+            if (!(c->occupied[i / 64] & bit)) return Result::InvalidArgument;
+
+            c->Slot(i)->~T();
+            c->occupied[i / 64] &= ~bit;
+            --m_size;
+            if (!c->inFreeList) link_free(c);
+
+            if (--c->count == 0 && (c->prevFree || c->nextFree)) {
+                unlink_free(c);
+                const size_type idx = lower_bound(c);
+                m_chunks.erase(idx);
+                free_chunk_memory(c);
+            }
+            return Result::Success;
+        }
+
+        Result erase(const_iterator it) noexcept {
+            return erase(&*it);
+        }
+
+        /**
+         * @brief Returns true if the pointer refers to a live element of this container.
+         */
+        bool contains(const T* element) const noexcept {
+            const Chunk* c = find_chunk(element);
+            if (!c) return false;
+            const size_type i = static_cast<size_type>(element - c->Slot(0));
+            return c->occupied[i / 64] & (uint64_t(1) << (i % 64));
+        }
+
+        /**
+         * @brief Calls func on every live element, this is the fastest way to visit the container.
+         */
+        template<typename F>
+        void for_each(F&& func) {
+            for (size_type ci = 0; ci < m_chunks.size(); ++ci) {
+                Chunk* c = m_chunks[ci];
+                for (size_type w = 0; w < Words; ++w) {
+                    for (uint64_t bits = c->occupied[w]; bits; bits &= bits - 1)
+                        func(*c->Slot(w * 64 + std::countr_zero(bits)));
+                }
+            }
+        }
+
+        template<typename F>
+        void for_each(F&& func) const {
+            for (size_type ci = 0; ci < m_chunks.size(); ++ci) {
+                const Chunk* c = m_chunks[ci];
+                for (size_type w = 0; w < Words; ++w) {
+                    for (uint64_t bits = c->occupied[w]; bits; bits &= bits - 1)
+                        func(*c->Slot(w * 64 + std::countr_zero(bits)));
+                }
+            }
+        }
+
+        /**
+         * @brief Destroys every element, chunks are kept for reuse.
+         */
+        void clear() noexcept {
+            for (size_type ci = 0; ci < m_chunks.size(); ++ci) {
+                Chunk* c = m_chunks[ci];
+                destroy_elements(c);
+                if (!c->inFreeList) link_free(c);
+            }
+            m_size = 0;
+        }
+
+        /**
+         * @brief Releases every chunk that holds no element.
+         */
+        void shrink_to_fit() noexcept {
+            for (size_type ci = m_chunks.size(); ci-- > 0;) {
+                Chunk* c = m_chunks[ci];
+                if (c->count) continue;
+                unlink_free(c);
+                m_chunks.erase(ci);
+                free_chunk_memory(c);
+            }
+            m_chunks.shrink_to_fit();
+        }
+
+        iterator begin() noexcept { return iterator(m_chunks.begin(), m_chunks.end()); }
+        iterator end() noexcept { return iterator(m_chunks.end(), m_chunks.end()); }
+        const_iterator begin() const noexcept { return const_iterator(m_chunks.begin(), m_chunks.end()); }
+        const_iterator end() const noexcept { return const_iterator(m_chunks.end(), m_chunks.end()); }
+        const_iterator cbegin() const noexcept { return begin(); }
+        const_iterator cend() const noexcept { return end(); }
+
+        bool empty() const noexcept { return m_size == 0; }
+        size_type size() const noexcept { return m_size; }
+        size_type capacity() const noexcept { return m_chunks.size() * ChunkSize; }
+        size_type chunk_count() const noexcept { return m_chunks.size(); }
+
+    private:
+        void release() noexcept {
+            for (size_type ci = 0; ci < m_chunks.size(); ++ci) {
+                destroy_elements(m_chunks[ci]);
+                free_chunk_memory(m_chunks[ci]);
+            }
+            m_chunks.clear();
+            m_freeHead = nullptr;
+            m_size = 0;
+        }
+    };
+}
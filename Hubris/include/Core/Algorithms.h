@@ -0,0 +1,754 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <bit>
+#include <span>
+#include <ranges>
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <vector>
+#include "Core/ThreadPool.h"
+#include "List.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HBR_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+#if defined(__SSE4_1__) || defined(__AVX__)
+#define HBR_SIMD_SSE41
+#include <smmintrin.h>
+#endif
+
+/**
+ * @brief Bulk algorithms over contiguous ranges (List<T>, std::vector, std::span, arrays).
+ *
+ * Work is split in chunks that run on the ThreadPool, the calling thread always processes the first chunk.
+ * Small inputs (below the grain) run serially on the caller. SIMD paths are used for 32-bit integer and float elements when available.
+ */
+namespace Hubris::Algorithms {
+    /**
+     * @brief Default number of elements below which a range is not split further.
+     */
+    inline constexpr size_t DefaultGrain = 4096;
+
+    template<typename R>
+    concept ContiguousRange = std::ranges::contiguous_range<R> && std::ranges::sized_range<R>;
+
+    template<ContiguousRange R>
+    using RangeElement = std::remove_reference_t<std::ranges::range_reference_t<R>>;
+
+    template<ContiguousRange R>
+    constexpr std::span<RangeElement<R>> ToSpan(R&& range) noexcept {
+        return std::span<RangeElement<R>>(std::ranges::data(range), std::ranges::size(range));
+    }
+
+    template<typename T>
+    struct MinMaxResult {
+        T Min;
+        T Max;
+    };
+
+    namespace Detail {
+        inline size_t ChunkCount(size_t count, size_t grain) noexcept {
+            const size_t workers = ThreadPool::GetThreadCount() + 1;
+            const size_t byGrain = (count + grain - 1) / std::max<size_t>(grain, 1);
+            //A few chunks per thread smooth out uneven chunk costs.
+            return std::clamp<size_t>(byGrain, 1, workers * 4);
+        }
+
+        constexpr size_t ChunkBegin(size_t count, size_t chunks, size_t chunk) noexcept {
+            return (count / chunks) * chunk + std::min(chunk, count % chunks);
+        }
+
+        /**
+         * @brief Runs fn(chunk, begin, end) for each of the chunks evenly splitting [0, count) and returns once all have run.
+         */
+        template<typename F>
+        void ForEachChunk(size_t count, size_t chunks, F&& fn) {
+            if (chunks <= 1) {
+                fn(size_t(0), size_t(0), count);
+                return;
+            }
+            WaitGroup wg;
+            for (size_t c = 1; c < chunks; ++c) {
+                ThreadPool::QueueJob(&wg, [&fn, count, chunks, c]() {
+                    fn(c, ChunkBegin(count, chunks, c), ChunkBegin(count, chunks, c + 1));
+                });
+            }
+            fn(size_t(0), size_t(0), ChunkBegin(count, chunks, 1));
+            ThreadPool::Wait(wg);
+        }
+
+        template<typename F>
+        void InvokeBatch(F& fn, size_t begin, size_t end) {
+            if constexpr (std::is_invocable_v<F&, size_t, size_t>) {
+                fn(begin, end);
+            }
+            else {
+                for (size_t i = begin; i < end; ++i) fn(i);
+            }
+        }
+
+        /**
+         * @brief Shared by every piece of one ParallelFor. Piece boundaries fall on multiples of Grain, shifted by Phase.
+         */
+        template<typename F>
+        struct ParallelForState {
+            F Fn;
+            size_t Grain;
+            size_t Phase;
+            WaitGroup* Group;                       // Done() once every element ran.
+            bool Owned;                             // Heap allocated, released by the last piece.
+            std::atomic<size_t> Remaining;          // Elements not processed yet.
+            std::atomic<unsigned int> Queued{ 0 };  // Split pieces not picked up yet.
+
+            template<typename Fn_>
+            ParallelForState(Fn_&& fn, size_t grain, size_t phase, WaitGroup* group, bool owned, size_t count)
+                : Fn(std::forward<Fn_>(fn)), Grain(grain), Phase(phase), Group(group), Owned(owned), Remaining(count) {}
+
+            size_t AlignDown(size_t x) const noexcept {
+                return (x + Phase) / Grain * Grain - Phase;
+            }
+        };
+
+        /**
+         * @brief Runs [begin, end) in Grain sized batches. Between batches, the upper half of what is left is handed to the pool,
+         * but only while some workers are idle and not already about to pick up an earlier half.
+         */
+        template<typename F>
+        void ParallelForPiece(ParallelForState<F>* state, size_t begin, size_t end) {
+            const size_t grain = state->Grain;
+            size_t processed = 0;
+            while (begin < end) {
+                if (end - begin >= 2 * grain && ThreadPool::GetIdleWorkerCount() > state->Queued.load(std::memory_order_relaxed)) {
+                    const size_t mid = state->AlignDown(begin + (end - begin) / 2);
+                    if (mid > begin && mid < end) {
+                        state->Queued.fetch_add(1, std::memory_order_relaxed);
+                        ThreadPool::QueueJob(nullptr, [state, mid, end]() {
+                            state->Queued.fetch_sub(1, std::memory_order_relaxed);
+                            ParallelForPiece(state, mid, end);
+                        });
+                        end = mid;
+                        continue;
+                    }
+                }
+                const size_t stop = std::min(end, state->AlignDown(begin + grain));
+                InvokeBatch(state->Fn, begin, stop);
+                processed += stop - begin;
+                begin = stop;
+            }
+            if (state->Remaining.fetch_sub(processed, std::memory_order_acq_rel) != processed) return;
+            WaitGroup* group = state->Group;
+            if (state->Owned) delete state;
+            group->Done();
+        }
+
+        /**
+         * @brief One chunk's partial result, alone on its cache line(s): chunks finishing at the same time do not contend on the line.
+         */
+        template<typename T>
+        struct alignas(CacheLineSize) Partial {
+            std::optional<T> Value;
+        };
+
+        template<typename T>
+        constexpr bool IsSimd32 = (std::is_same_v<T, float> || (std::is_integral_v<T> && sizeof(T) == 4));
+
+        template<typename T>
+        size_t FindSerial(const T* data, size_t count, const T& value) noexcept {
+            size_t i = 0;
+#ifdef HBR_SIMD_SSE2
+            if constexpr (std::is_same_v<T, float>) {
+                const __m128 needle = _mm_set1_ps(value);
+                for (; i + 4 <= count; i += 4) {
+                    const int mask = _mm_movemask_ps(_mm_cmpeq_ps(_mm_loadu_ps(data + i), needle));
+                    if (mask) return i + std::countr_zero(static_cast<unsigned>(mask));
+                }
+            }
+            else if constexpr (IsSimd32<T>) {
+                const __m128i needle = _mm_set1_epi32(static_cast<int>(value));
+                for (; i + 4 <= count; i += 4) {
+                    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                    const int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, needle)));
+                    if (mask) return i + std::countr_zero(static_cast<unsigned>(mask));
+                }
+            }
+#endif
+            for (; i < count; ++i)
+                if (data[i] == value) return i;
+            return count;
+        }
+
+        template<typename T>
+        MinMaxResult<T> MinMaxSerial(const T* data, size_t count) noexcept {
+            MinMaxResult<T> r{ data[0], data[0] };
+            size_t i = 0;
+#ifdef HBR_SIMD_SSE2
+            if constexpr (std::is_same_v<T, float>) {
+                if (count >= 4) {
+                    __m128 lo = _mm_loadu_ps(data), hi = lo;
+                    for (i = 4; i + 4 <= count; i += 4) {
+                        const __m128 v = _mm_loadu_ps(data + i);
+                        lo = _mm_min_ps(lo, v);
+                        hi = _mm_max_ps(hi, v);
+                    }
+                    alignas(16) float l[4], h[4];
+                    _mm_store_ps(l, lo);
+                    _mm_store_ps(h, hi);
+                    r = { std::min({ l[0], l[1], l[2], l[3] }), std::max({ h[0], h[1], h[2], h[3] }) };
+                }
+            }
+#ifdef HBR_SIMD_SSE41
+            else if constexpr (IsSimd32<T>) {
+                if (count >= 4) {
+                    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)), hi = lo;
+                    for (i = 4; i + 4 <= count; i += 4) {
+                        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                        if constexpr (std::is_signed_v<T>) {
+                            lo = _mm_min_epi32(lo, v);
+                            hi = _mm_max_epi32(hi, v);
+                        }
+                        else {
+                            lo = _mm_min_epu32(lo, v);
+                            hi = _mm_max_epu32(hi, v);
+                        }
+                    }
+                    alignas(16) T l[4], h[4];
+                    _mm_store_si128(reinterpret_cast<__m128i*>(l), lo);
+                    _mm_store_si128(reinterpret_cast<__m128i*>(h), hi);
+                    r = { std::min({ l[0], l[1], l[2], l[3] }), std::max({ h[0], h[1], h[2], h[3] }) };
+                }
+            }
+#endif
+#endif
+            for (; i < count; ++i) {
+                if (data[i] < r.Min) r.Min = data[i];
+                if (r.Max < data[i]) r.Max = data[i];
+            }
+            return r;
+        }
+
+        /**
+         * @brief Maps an arithmetic key to an unsigned integer with the same ordering.
+         */
+        template<typename K>
+        constexpr auto RadixKey(K key) noexcept {
+            if constexpr (std::is_floating_point_v<K>) {
+                static_assert(sizeof(K) == 4 || sizeof(K) == 8, "Unsupported floating point key.");
+                using U = std::conditional_t<sizeof(K) == 4, uint32_t, uint64_t>;
+                const U bits = std::bit_cast<U>(key);
+                constexpr U sign = U(1) << (sizeof(U) * 8 - 1);
+                //Negative floats sort reversed, flip all their bits. Positive ones only need the sign bit set.
+                return (bits & sign) ? U(~bits) : U(bits | sign);
+            }
+            else if constexpr (std::is_signed_v<K>) {
+                using U = std::make_unsigned_t<K>;
+                return U(U(key) ^ (U(1) << (sizeof(U) * 8 - 1)));
+            }
+            else {
+                static_assert(std::is_unsigned_v<K>, "Radix keys must be integers or floating point values.");
+                return key;
+            }
+        }
+    }
+
+    /**
+     * @brief Stable LSD radix sort (8 bits per pass) by an arithmetic key.
+     *
+     * Each pass builds per-chunk histograms in parallel, then scatters in parallel. Passes where every key shares the same byte are skipped.
+     * @param key Callable returning an integer or floating point key for an element.
+     */
+    template<ContiguousRange R, typename KeyFn>
+    void RadixSort(R&& range, KeyFn&& key, size_t grain = DefaultGrain) {
+        using T = RangeElement<R>;
+        static_assert(std::is_trivially_copyable_v<T>, "RadixSort moves elements with memcpy, T must be trivially copyable.");
+        using Key = decltype(Detail::RadixKey(key(std::declval<const T&>())));
+
+        std::span<T> data = ToSpan(range);
+        const size_t count = data.size();
+        if (count < 2) return;
+
+        BasicStore<T> scratch(count);
+        if (!scratch) {
+            //Out of memory, fall back to an in-place comparison sort.
+            std::stable_sort(data.begin(), data.end(), [&](const T& a, const T& b) {
+                return Detail::RadixKey(key(a)) < Detail::RadixKey(key(b));
+            });
+            return;
+        }
+
+        const size_t chunks = Detail::ChunkCount(count, grain);
+        List<size_t> offsets(chunks * 256);
+        T* src = data.data();
+        T* dst = &scratch[0];
+
+        for (unsigned shift = 0; shift < sizeof(Key) * 8; shift += 8) {
+            size_t* hist = offsets.data();
+            std::memset(hist, 0, chunks * 256 * sizeof(size_t));
+            Detail::ForEachChunk(count, chunks, [&](size_t c, size_t begin, size_t end) {
+                size_t* h = hist + c * 256;
+                for (size_t i = begin; i < end; ++i)
+                    ++h[(Detail::RadixKey(key(src[i])) >> shift) & 0xFF];
+            });
+
+            //Turn the histograms into write offsets, digit-major so the scatter stays stable.
+            size_t running = 0;
+            bool trivial = false;
+            for (size_t d = 0; d < 256; ++d) {
+                const size_t start = running;
+                for (size_t c = 0; c < chunks; ++c) {
+                    const size_t n = hist[c * 256 + d];
+                    hist[c * 256 + d] = running;
+                    running += n;
+                }
+                if (running - start == count) trivial = true;
+            }
+            if (trivial) continue;
+
+            Detail::ForEachChunk(count, chunks, [&](size_t c, size_t begin, size_t end) {
+                size_t* o = hist + c * 256;
+                for (size_t i = begin; i < end; ++i)
+                    std::memcpy(dst + o[(Detail::RadixKey(key(src[i])) >> shift) & 0xFF]++, src + i, sizeof(T));
+            });
+            std::swap(src, dst);
+        }
+
+        if (src != data.data())
+            std::memcpy(data.data(), src, count * sizeof(T));
+    }
+
+    /**
+     * @brief Radix sorts a range of integers or floating point values in ascending order.
+     */
+    template<ContiguousRange R> requires std::is_arithmetic_v<RangeElement<R>>
+    void RadixSort(R&& range, size_t grain = DefaultGrain) {
+        RadixSort(std::forward<R>(range), [](const RangeElement<R>& v) { return v; }, grain);
+    }
+
+    /**
+     * @brief Comparison sort: chunks are sorted in parallel then merged pairwise in parallel rounds. Not stable.
+     */
+    template<ContiguousRange R, typename Compare = std::less<>>
+    void Sort(R&& range, Compare comp = {}, size_t grain = DefaultGrain) {
+        auto data = ToSpan(range);
+        const size_t count = data.size();
+        const size_t chunks = Detail::ChunkCount(count, grain);
+        if (chunks <= 1) {
+            std::sort(data.begin(), data.end(), comp);
+            return;
+        }
+        Detail::ForEachChunk(count, chunks, [&](size_t, size_t begin, size_t end) {
+            std::sort(data.begin() + begin, data.begin() + end, comp);
+        });
+        for (size_t width = 1; width < chunks; width *= 2) {
+            const size_t merges = (chunks + 2 * width - 1) / (2 * width);
+            Detail::ForEachChunk(merges, merges, [&](size_t m, size_t, size_t) {
+                const size_t first = m * 2 * width;
+                const size_t mid = std::min(first + width, chunks);
+                const size_t last = std::min(first + 2 * width, chunks);
+                if (mid == last) return;
+                std::inplace_merge(data.begin() + Detail::ChunkBegin(count, chunks, first),
+                                   data.begin() + Detail::ChunkBegin(count, chunks, mid),
+                                   data.begin() + Detail::ChunkBegin(count, chunks, last), comp);
+            });
+        }
+    }
+
+    /**
+     * @brief Copies the elements satisfying pred from in to out, keeping their order (stream compaction).
+     * @param out Must hold at least in.size() elements.
+     * @return The number of elements written.
+     */
+    template<ContiguousRange In, ContiguousRange Out, typename Pred>
+    size_t Compact(In&& in, Out&& out, Pred&& pred, size_t grain = DefaultGrain) {
+        auto src = ToSpan(in);
+        auto dst = ToSpan(out);
+        assert(dst.size() >= src.size() && "Compact output is smaller than the input.");
+        const size_t count = src.size();
+        const size_t chunks = Detail::ChunkCount(count, grain);
+        if (chunks <= 1) {
+            size_t n = 0;
+            for (size_t i = 0; i < count; ++i)
+                if (pred(src[i])) dst[n++] = src[i];
+            return n;
+        }
+
+        List<size_t> kept(chunks + 1, 0);
+        Detail::ForEachChunk(count, chunks, [&](size_t c, size_t begin, size_t end) {
+            size_t n = 0;
+            for (size_t i = begin; i < end; ++i) n += pred(src[i]) ? 1 : 0;
+            kept[c + 1] = n;
+        });
+        for (size_t c = 0; c < chunks; ++c) kept[c + 1] += kept[c];
+        Detail::ForEachChunk(count, chunks, [&](size_t c, size_t begin, size_t end) {
+            size_t o = kept[c];
+            for (size_t i = begin; i < end; ++i)
+                if (pred(src[i])) dst[o++] = src[i];
+        });
+        return kept[chunks];
+    }
+
+    /**
+     * @brief Reorders the range so the elements satisfying pred come first, the relative order inside both groups is preserved.
+     * @return The number of elements satisfying pred.
+     */
+    template<ContiguousRange R, typename Pred>
+    size_t StablePartition(R&& range, Pred&& pred, size_t grain = DefaultGrain) {
+        using T = RangeElement<R>;
+        auto data = ToSpan(range);
+        const size_t count = data.size();
+        const size_t chunks = Detail::ChunkCount(count, grain);
+        if (chunks <= 1 || !std::is_nothrow_move_constructible_v<T>) {
+            return static_cast<size_t>(std::stable_partition(data.begin(), data.end(), pred) - data.begin());
+        }
+        BasicStore<T> scratch(count);
+        if (!scratch) {
+            return static_cast<size_t>(std::stable_partition(data.begin(), data.end(), pred) - data.begin());
+        }
+
+        //[c] = elements kept by chunks before c, computed from the per chunk counts.
+        List<size_t> kept(chunks + 1, 0);
+        Detail::ForEachChunk(count, chunks, [&](size_t c, size_t begin, size_t end) {
+            size_t n = 0;
+            for (size_t i = begin; i < end; ++i) n += pred(data[i]) ? 1 : 0;
+            kept[c + 1] = n;
+        });
+        for (size_t c = 0; c < chunks; ++c) kept[c + 1] += kept[c];
+        const size_t total = kept[chunks];
+
+        Detail::ForEachChunk(count, chunks, [&](size_t c, size_t begin, size_t end) {
+            size_t t = kept[c];
+            size_t f = total + (begin - kept[c]);
+            for (size_t i = begin; i < end; ++i) {
+                T* slot = pred(data[i]) ? &scratch[t++] : &scratch[f++];
+                new(slot) T(std::move(data[i]));
+            }
+        });
+        Detail::ForEachChunk(count, chunks, [&](size_t, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                data[i] = std::move(scratch[i]);
+                scratch[i].~T();
+            }
+        });
+        return total;
+    }
+
+    /**
+     * @brief Removes the elements of the list that do not satisfy pred, keeping the order of the others.
+     */
+    template<typename T, typename Pred>
+    void Filter(List<T>& list, Pred&& pred, size_t grain = DefaultGrain) {
+        const size_t kept = StablePartition(list, std::forward<Pred>(pred), grain);
+        while (list.size() > kept) list.pop_back();
+    }
+
+    /**
+     * @brief Finds the first element satisfying pred.
+     * @return Its index, or the range's size if none does.
+     */
+    template<ContiguousRange R, typename Pred>
+    size_t FindIf(R&& range, Pred&& pred, size_t grain = DefaultGrain) {
+        auto data = ToSpan(range);
+        const size_t count = data.size();
+        const size_t chunks = Detail::ChunkCount(count, grain);
+        std::atomic<size_t> found{ count };
+        Detail::ForEachChunk(count, chunks, [&](size_t, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                //A match was already found before this point, nothing here can be first.
+                if ((i & 1023) == 0 && found.load(std::memory_order_relaxed) < i) return;
+                if (pred(data[i])) {
+                    size_t cur = found.load(std::memory_order_relaxed);
+                    while (i < cur && !found.compare_exchange_weak(cur, i, std::memory_order_relaxed)) {}
+                    return;
+                }
+            }
+        });
+        return found.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Finds the first element equal to value, using SIMD compares for 32-bit integers and floats.
+     * @return Its index, or the range's size if there is none.
+     */
+    template<ContiguousRange R>
+    size_t Find(R&& range, const RangeElement<R>& value, size_t grain = DefaultGrain) {
+        using T = std::remove_cv_t<RangeElement<R>>;
+        auto data = ToSpan(range);
+        const size_t count = data.size();
+        const size_t chunks = Detail::ChunkCount(count, grain * 4);
+        std::atomic<size_t> found{ count };
+        Detail::ForEachChunk(count, chunks, [&](size_t, size_t begin, size_t end) {
+            const size_t i = begin + Detail::FindSerial<T>(data.data() + begin, end - begin, value);
+            if (i == end) return;
+            size_t cur = found.load(std::memory_order_relaxed);
+            while (i < cur && !found.compare_exchange_weak(cur, i, std::memory_order_relaxed)) {}
+        });
+        return found.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Returns the smallest and largest elements, the range must not be empty.
+     *
+     * The SIMD float path follows minps/maxps semantics, results are unspecified if the range holds NaNs.
+     */
+    template<ContiguousRange R>
+    MinMaxResult<std::remove_cv_t<RangeElement<R>>> MinMax(R&& range, size_t grain = DefaultGrain) {
+        using T = std::remove_cv_t<RangeElement<R>>;
+        auto data = ToSpan(range);
+        const size_t count = data.size();
+        assert(count > 0 && "MinMax of an empty range.");
+        const size_t chunks = Detail::ChunkCount(count, grain * 4);
+        if (chunks <= 1) return Detail::MinMaxSerial<T>(data.data(), count);
+
+        BasicStore<MinMaxResult<T>> partial(chunks);
+        Detail::ForEachChunk(count, chunks, [&](size_t c, size_t begin, size_t end) {
+            new(&partial[c]) MinMaxResult<T>(Detail::MinMaxSerial<T>(data.data() + begin, end - begin));
+        });
+        MinMaxResult<T> r = partial[0];
+        for (size_t c = 1; c < chunks; ++c) {
+            if (partial[c].Min < r.Min) r.Min = partial[c].Min;
+            if (r.Max < partial[c].Max) r.Max = partial[c].Max;
+        }
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            for (size_t c = 0; c < chunks; ++c) partial[c].~MinMaxResult<T>();
+        }
+        return r;
+    }
+
+    /**
+     * @brief Combines transform(e) of every element e with reduce, starting from identity: reduce(...reduce(identity, t(r[0]))..., t(r[n - 1])).
+     *
+     * Every chunk is folded from identity into its own padded partial, the partials are then combined in order on the calling thread.
+     * reduce must be associative and identity neutral, reduce need not be commutative: the result does not depend on the thread count.
+     */
+    template<ContiguousRange R, typename T, typename Reduce, typename Transform>
+    T ParallelTransformReduce(R&& range, T identity, Reduce reduce, Transform transform, size_t grain = DefaultGrain) {
+        auto data = ToSpan(range);
+        const size_t count = data.size();
+        const size_t chunks = Detail::ChunkCount(count, grain);
+
+        auto fold = [&](T acc, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) acc = reduce(std::move(acc), transform(data[i]));
+            return acc;
+        };
+        if (chunks <= 1) return fold(std::move(identity), 0, count);
+
+        std::vector<Detail::Partial<T>> partial(chunks);
+        Detail::ForEachChunk(count, chunks, [&](size_t c, size_t begin, size_t end) {
+            partial[c].Value.emplace(fold(identity, begin, end));
+        });
+        T result = std::move(*partial[0].Value);
+        for (size_t c = 1; c < chunks; ++c) result = reduce(std::move(result), std::move(*partial[c].Value));
+        return result;
+    }
+
+    /**
+     * @brief Combines every element with op, starting from identity. Same rules as ParallelTransformReduce.
+     *
+     * For example the bounds of a scene, or the sum of a column: ParallelReduce(std::span(column), 0.0f, std::plus<>{}).
+     */
+    template<ContiguousRange R, typename T, typename Op>
+    T ParallelReduce(R&& range, T identity, Op op, size_t grain = DefaultGrain) {
+        return ParallelTransformReduce(std::forward<R>(range), std::move(identity), std::move(op), std::identity{}, grain);
+    }
+
+    /**
+     * @brief out[i] = in[0] op in[1] op ... op in[i]. op must be associative. in and out may be the same range.
+     *
+     * Reduce then scan: the first chunk is scanned right away while the others are only reduced to their totals,
+     * then every other chunk is scanned seeded with the combined totals before it.
+     */
+    template<ContiguousRange In, ContiguousRange Out, typename Op>
+    void ParallelInclusiveScan(In&& in, Out&& out, Op op, size_t grain = DefaultGrain) {
+        using T = std::remove_cv_t<RangeElement<Out>>;
+        auto src = ToSpan(in);
+        auto dst = ToSpan(out);
+        assert(dst.size() >= src.size() && "Scan output is smaller than the input.");
+        const size_t count = src.size();
+        if (count == 0) return;
+        const size_t chunks = Detail::ChunkCount(count, grain);
+
+        auto scan = [&](size_t begin, size_t end, T carry) {
+            for (size_t i = begin; i < end; ++i) {
+                carry = op(std::move(carry), src[i]);
+                dst[i] = carry;
+            }
+            return carry;
+        };
+        auto scanFirst = [&](size_t begin, size_t end) {
+            T carry(src[begin]);
+            dst[begin] = carry;
+            return scan(begin + 1, end, std::move(carry));
+        };
+        if (chunks <= 1) {
+            scanFirst(0, count);
+            return;
+        }
+
+        std::vector<Detail::Partial<T>> totals(chunks);
+        Detail::ForEachChunk(count, chunks, [&](size_t c, size_t begin, size_t end) {
+            if (c == 0) {
+                totals[0].Value.emplace(scanFirst(begin, end));
+            }
+            else if (c + 1 < chunks) {
+                //The last chunk's total is never needed.
+                T sum(src[begin]);
+                for (size_t i = begin + 1; i < end; ++i) sum = op(std::move(sum), src[i]);
+                totals[c].Value.emplace(std::move(sum));
+            }
+        });
+        for (size_t c = 1; c + 1 < chunks; ++c) totals[c].Value = op(*totals[c - 1].Value, *totals[c].Value);
+        Detail::ForEachChunk(count, chunks, [&](size_t c, size_t begin, size_t end) {
+            if (c > 0) scan(begin, end, *totals[c - 1].Value);
+        });
+    }
+
+    /**
+     * @brief out[0] = init, out[i] = init op in[0] op ... op in[i - 1]. op must be associative. in and out may be the same range.
+     *
+     * Typically the write offsets of a stream compaction: scan the per-element counts, then scatter.
+     * @return init combined with every element, the total.
+     */
+    template<ContiguousRange In, ContiguousRange Out, typename T, typename Op>
+    std::remove_cv_t<RangeElement<Out>> ParallelExclusiveScan(In&& in, Out&& out, T init, Op op, size_t grain = DefaultGrain) {
+        using V = std::remove_cv_t<RangeElement<Out>>;
+        auto src = ToSpan(in);
+        auto dst = ToSpan(out);
+        assert(dst.size() >= src.size() && "Scan output is smaller than the input.");
+        const size_t count = src.size();
+        const size_t chunks = Detail::ChunkCount(count, grain);
+
+        auto scan = [&](size_t begin, size_t end, V carry) {
+            for (size_t i = begin; i < end; ++i) {
+                V next = op(carry, src[i]);
+                dst[i] = std::move(carry);
+                carry = std::move(next);
+            }
+            return carry;
+        };
+        if (chunks <= 1) return scan(0, count, V(std::move(init)));
+
+        std::vector<Detail::Partial<V>> totals(chunks);
+        Detail::ForEachChunk(count, chunks, [&](size_t c, size_t begin, size_t end) {
+            if (c == 0) {
+                totals[0].Value.emplace(scan(begin, end, V(init)));
+            }
+            else if (c + 1 < chunks) {
+                V sum(src[begin]);
+                for (size_t i = begin + 1; i < end; ++i) sum = op(std::move(sum), src[i]);
+                totals[c].Value.emplace(std::move(sum));
+            }
+        });
+        for (size_t c = 1; c + 1 < chunks; ++c) totals[c].Value = op(*totals[c - 1].Value, *totals[c].Value);
+        Detail::ForEachChunk(count, chunks, [&](size_t c, size_t begin, size_t end) {
+            if (c + 1 == chunks) totals[c].Value.emplace(scan(begin, end, *totals[c - 1].Value));
+            else if (c > 0) scan(begin, end, *totals[c - 1].Value);
+        });
+        return std::move(*totals[chunks - 1].Value);
+    }
+
+    /**
+     * @brief out[i] = in[0] + ... + in[i]. in and out may be the same range.
+     */
+    template<ContiguousRange In, ContiguousRange Out>
+    void InclusivePrefixSum(In&& in, Out&& out, size_t grain = DefaultGrain) {
+        ParallelInclusiveScan(std::forward<In>(in), std::forward<Out>(out), std::plus<>{}, grain);
+    }
+
+    /**
+     * @brief out[i] = in[0] + ... + in[i - 1], out[0] = T{}. in and out may be the same range.
+     * @return The total of all elements.
+     */
+    template<ContiguousRange In, ContiguousRange Out>
+    std::remove_cv_t<RangeElement<Out>> ExclusivePrefixSum(In&& in, Out&& out, size_t grain = DefaultGrain) {
+        return ParallelExclusiveScan(std::forward<In>(in), std::forward<Out>(out), std::remove_cv_t<RangeElement<Out>>{}, std::plus<>{}, grain);
+    }
+
+    /**
+     * @brief Default ParallelFor batch size, in elements.
+     */
+    inline constexpr size_t DefaultForGrain = 256;
+
+    /**
+     * @brief Calls fn for every index in [begin, end) on the pool and returns once all ran, the calling thread takes part.
+     *
+     * The range is not split up front: it is processed in batches of grain indices and halves of the remainder are handed to the pool
+     * only while workers are idle, so busy frames do not pay for parallelism they cannot use. Small ranges run inline.
+     * @param grain Batch size, the smallest piece ever handed to another thread. Pieces start on multiples of grain from begin.
+     * @param fn Either fn(size_t index) or fn(size_t batchBegin, size_t batchEnd).
+     */
+    template<typename F>
+    void ParallelFor(size_t begin, size_t end, size_t grain, F&& fn) {
+        if (begin >= end) return;
+        grain = std::max<size_t>(grain, 1);
+        if (end - begin <= grain || ThreadPool::GetThreadCount() == 0) {
+            Detail::InvokeBatch(fn, begin, end);
+            return;
+        }
+        WaitGroup wg;
+        wg.Add(1);
+        Detail::ParallelForState<F&> state(fn, grain, (grain - begin % grain) % grain, &wg, false, end - begin);
+        Detail::ParallelForPiece(&state, begin, end);
+        ThreadPool::Wait(wg);
+    }
+
+    /**
+     * @brief Asynchronous ParallelFor: fn is copied and the loop runs on the pool, wg is signaled (Add(1) now, Done() at the end) once every index ran.
+     *
+     * Ranges no larger than grain run inline before returning, without touching wg.
+     */
+    template<typename F>
+    void ParallelFor(WaitGroup& wg, size_t begin, size_t end, size_t grain, F&& fn) {
+        if (begin >= end) return;
+        grain = std::max<size_t>(grain, 1);
+        if (end - begin <= grain) {
+            Detail::InvokeBatch(fn, begin, end);
+            return;
+        }
+        using State = Detail::ParallelForState<std::decay_t<F>>;
+        auto* state = new State(std::forward<F>(fn), grain, (grain - begin % grain) % grain, &wg, true, end - begin);
+        wg.Add(1);
+        ThreadPool::QueueJob(nullptr, [state, begin, end]() { Detail::ParallelForPiece(state, begin, end); });
+    }
+
+    /**
+     * @brief ParallelFor over the elements of a contiguous range, fn is either fn(T&) or fn(std::span<T>) for a whole batch.
+     *
+     * The grain is rounded up to whole cache lines and batches start on cache-line boundaries, two threads never write to the same line.
+     */
+    template<ContiguousRange R, typename F>
+    void ParallelFor(R&& range, F&& fn, size_t grain = DefaultForGrain) {
+        using T = RangeElement<R>;
+        std::span<T> data = ToSpan(range);
+        if (data.empty()) return;
+
+        constexpr size_t perLine = (sizeof(T) < CacheLineSize && CacheLineSize % sizeof(T) == 0) ? CacheLineSize / sizeof(T) : 1;
+        grain = (std::max<size_t>(grain, 1) + perLine - 1) / perLine * perLine;
+        //Elements before the first cache-line boundary.
+        const uintptr_t address = reinterpret_cast<uintptr_t>(data.data());
+        const size_t lead = (perLine > 1 && address % sizeof(T) == 0) ? ((CacheLineSize - address % CacheLineSize) % CacheLineSize) / sizeof(T) : 0;
+
+        auto batch = [&fn, data](size_t begin, size_t end) {
+            if constexpr (std::is_invocable_v<F&, std::span<T>>) {
+                fn(data.subspan(begin, end - begin));
+            }
+            else {
+                for (size_t i = begin; i < end; ++i) fn(data[i]);
+            }
+        };
+        if (data.size() <= grain || ThreadPool::GetThreadCount() == 0) {
+            batch(0, data.size());
+            return;
+        }
+        WaitGroup wg;
+        wg.Add(1);
+        Detail::ParallelForState<decltype(batch)&> state(batch, grain, (grain - lead % grain) % grain, &wg, false, data.size());
+        Detail::ParallelForPiece(&state, 0, data.size());
+        ThreadPool::Wait(wg);
+    }
+}
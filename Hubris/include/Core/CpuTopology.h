@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+namespace Hubris {
+    /**
+     * @brief One hardware thread as seen by the OS scheduler.
+     */
+    struct LogicalCpu {
+        uint32_t Id = 0;            // OS processor number (Windows: group * 64 + index in group).
+        uint32_t Core = 0;          // Physical core, dense index over the machine.
+        uint32_t Sibling = 0;       // SMT index inside the core, 0 for the first hardware thread.
+        uint32_t Cache = 0;         // Last level cache (L3) domain, dense index.
+        uint32_t Node = 0;          // NUMA node.
+        uint32_t Package = 0;       // Socket.
+    };
+
+    /**
+     * @brief The processor layout of the machine: physical cores, SMT siblings, L3 domains, NUMA nodes and packages.
+     *
+     * Read from /sys/devices/system on Linux and GetLogicalProcessorInformationEx on Windows.
+     * Only the CPUs in the process' affinity mask are listed (sched_getaffinity, which includes the cgroup cpuset, or GetProcessAffinityMask),
+     * so a pool sized and pinned from it stays within what taskset or a container allows.
+     * If neither is available, every logical CPU is reported as its own core in a single cache domain and node.
+     */
+    class CpuTopology final {
+    public:
+        /**
+         * @brief How far apart two logical CPUs are, in increasing cost of sharing data between them.
+         */
+        enum class Distance : uint8_t {
+            Same,
+            SmtSibling,     // Same physical core.
+            SharedCache,    // Same L3.
+            SameNode,       // Same NUMA node, different L3.
+            SamePackage,    // Same socket, different node.
+            Remote          // Other socket.
+        };
+
+    private:
+        std::vector<LogicalCpu> m_cpus;
+        uint32_t m_coreCount = 0;
+        uint32_t m_cacheCount = 0;
+        uint32_t m_nodeCount = 0;
+        uint32_t m_packageCount = 0;
+        bool m_detected = false;
+
+        void Finalize();
+
+    public:
+        /**
+         * @brief The topology of this machine, detected on the first call.
+         */
+        static const CpuTopology& Get();
+
+        /**
+         * @brief Queries the OS, prefer Get() which caches the result.
+         */
+        static CpuTopology Detect();
+
+        /**
+         * @brief Restricts the calling thread to one logical CPU (an index in GetCpus()).
+         * @return false if the OS refused or affinity is not supported.
+         */
+        bool PinCurrentThread(uint32_t cpu) const;
+
+        const std::vector<LogicalCpu>& GetCpus() const noexcept { return m_cpus; }
+        uint32_t GetLogicalCount() const noexcept { return static_cast<uint32_t>(m_cpus.size()); }
+        uint32_t GetCoreCount() const noexcept { return m_coreCount; }
+        uint32_t GetCacheCount() const noexcept { return m_cacheCount; }
+        uint32_t GetNodeCount() const noexcept { return m_nodeCount; }
+        uint32_t GetPackageCount() const noexcept { return m_packageCount; }
+
+        /**
+         * @brief false if the OS could not be queried and the fallback layout is used.
+         */
+        bool IsDetected() const noexcept { return m_detected; }
+
+        Distance GetDistance(uint32_t a, uint32_t b) const noexcept;
+
+        /**
+         * @brief Every logical CPU index, first hardware threads of every core first (grouped by node then cache), SMT siblings after.
+         *
+         * Taking a prefix of this order spreads threads over physical cores before doubling up on one.
+         */
+        std::vector<uint32_t> GetSpreadOrder() const;
+    };
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+namespace Hubris {
+    template<typename Signature>
+    class Delegate;
+
+    /**
+     * @brief A callable stored inline, never on the heap: a function pointer, a member function bound to an object, or a small lambda.
+     *
+     * The callable must be trivially copyable and fit in StorageSize (a few pointers or values), so a Delegate is copied like plain data
+     * and a vector of them is walked as a tight loop. Capture larger state by pointer.
+     */
+    template<typename R, typename... Args>
+    class Delegate<R(Args...)> final {
+    public:
+        static constexpr size_t StorageSize = 16;
+
+        template<typename F>
+        static constexpr bool Fits = sizeof(F) <= StorageSize && alignof(F) <= 8 && std::is_trivially_copyable_v<F>;
+
+    private:
+        R(*m_invoke)(const void* storage, Args... args) = nullptr;
+        alignas(8) unsigned char m_storage[StorageSize] = {};
+
+    public:
+        Delegate() noexcept = default;
+
+        template<typename F>
+            requires (!std::is_same_v<std::decay_t<F>, Delegate> && std::is_invocable_r_v<R, const std::decay_t<F>&, Args...>)
+        Delegate(F&& func) noexcept {
+            using Fn = std::decay_t<F>;
+            static_assert(Fits<Fn>, "Delegate callable is too large or not trivially copyable, capture by pointer.");
+            new(m_storage) Fn(std::forward<F>(func));
+            m_invoke = [](const void* storage, Args... args) -> R {
+                return (*std::launder(static_cast<const Fn*>(storage)))(std::forward<Args>(args)...);
+            };
+        }
+
+        /**
+         * @brief Calls Method on object, which must outlive the delegate.
+         */
+        template<auto Method, typename T>
+        static Delegate Bind(T* object) noexcept {
+            return Delegate([object](Args... args) -> R { return (object->*Method)(std::forward<Args>(args)...); });
+        }
+
+        R operator()(Args... args) const {
+            return m_invoke(m_storage, std::forward<Args>(args)...);
+        }
+
+        explicit operator bool() const noexcept {
+            return m_invoke != nullptr;
+        }
+    };
+}
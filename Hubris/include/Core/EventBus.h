@@ -1,28 +1,498 @@
 #pragma once
+#include <span>
+#include <vector>
+#include <memory>
+#include <iterator>
+#include <algorithm>
 #include "ThreadPool.h"
+#include "Rcu.h"
+#include "Delegate.h"
+#include "StringId.h"
 
 namespace Hubris::Core {
-    //This is used for Core Event Bus
+    /**
+     * @brief The StaticEventBus types that queued events, flushed together once per frame by Engine::Loop.
+     */
+    class EventQueues final {
+    private:
+        static inline SpinLock lock;
+        static inline std::vector<void(*)()> flushes;
+
+        EventQueues() = delete;
+    public:
+        /**
+         * @brief Called by a bus the first time an event of its type is queued.
+         */
+        static void Register(void(*flush)()) {
+            std::lock_guard<SpinLock> guard(lock);
+            flushes.push_back(flush);
+        }
+
+        /**
+         * @brief Flushes every bus, in the order their first event was queued. Events queued by the handlers wait for the next call.
+         */
+        static void FlushAll() {
+            std::vector<void(*)()> snapshot;
+            {
+                std::lock_guard<SpinLock> guard(lock);
+                snapshot = flushes;
+            }
+            for (auto flush : snapshot) flush();
+            //Handler lists replaced while being read, retired since.
+            Rcu::Reclaim();
+        }
+    };
+
+    /**
+     * @brief How a handler may be called relative to the other handlers of the same event.
+     */
+    enum class HandlerConcurrency : uint8_t {
+        /**
+         * @brief Called on the dispatching thread, in subscription order.
+         */
+        Serial,
+        /**
+         * @brief Independent of every other handler: run as a job on the pool, concurrently with the rest, joined before Dispatch/Flush returns.
+         */
+        ParallelSafe
+    };
+
+    /**
+     * @brief Returned by Subscribe, identifies the subscription to remove. Stale tokens (already unsubscribed) are ignored.
+     */
+    struct Subscription {
+        uint32_t Slot = UINT32_MAX;
+        uint32_t Generation = 0;
+
+        bool IsValid() const noexcept { return Slot != UINT32_MAX; }
+    };
+
+    /**
+     * @brief Liveness of the subscriptions of a bus: one generation per slot, bumped by unsubscribing.
+     * Handler entries keep the generation they were subscribed with, an entry whose generation changed is a tombstone, skipped until compacted.
+     *
+     * Slots are allocated in chunks that never move, IsLive is lock-free. Acquire and Release are called under the bus's writer lock.
+     */
+    class SubscriptionTable final {
+    public:
+        static constexpr uint32_t ChunkSize = 256;
+        static constexpr uint32_t MaxChunks = 256;
+    private:
+        std::atomic<std::atomic<uint32_t>*> m_chunks[MaxChunks] = {};
+        std::vector<uint32_t> m_free;
+        uint32_t m_next = 0;
+
+        std::atomic<uint32_t>& Generation(uint32_t slot) const noexcept {
+            return m_chunks[slot / ChunkSize].load(std::memory_order_acquire)[slot % ChunkSize];
+        }
+    public:
+        SubscriptionTable() = default;
+        SubscriptionTable(const SubscriptionTable&) = delete;
+        SubscriptionTable& operator=(const SubscriptionTable&) = delete;
+        ~SubscriptionTable() {
+            for (auto& chunk : m_chunks) delete[] chunk.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @return An invalid subscription once ChunkSize * MaxChunks are live.
+         */
+        Subscription Acquire() {
+            uint32_t slot;
+            if (!m_free.empty()) {
+                slot = m_free.back();
+                m_free.pop_back();
+            }
+            else {
+                if (m_next == ChunkSize * MaxChunks) return {};
+                slot = m_next++;
+                if (slot % ChunkSize == 0) m_chunks[slot / ChunkSize].store(new std::atomic<uint32_t>[ChunkSize](), std::memory_order_release);
+            }
+            return { slot, Generation(slot).load(std::memory_order_relaxed) };
+        }
+
+        /**
+         * @return false if the subscription was not live.
+         */
+        bool Release(Subscription subscription) {
+            if (!subscription.IsValid() || subscription.Slot >= m_next) return false;
+            uint32_t expected = subscription.Generation;
+            if (!Generation(subscription.Slot).compare_exchange_strong(expected, expected + 1, std::memory_order_release, std::memory_order_relaxed))
+                return false;
+            //Entries still holding the old generation stay dead, the slot can serve again right away.
+            m_free.push_back(subscription.Slot);
+            return true;
+        }
+
+        bool IsLive(uint32_t slot, uint32_t generation) const noexcept {
+            return Generation(slot).load(std::memory_order_acquire) == generation;
+        }
+    };
+
+    /**
+     * @brief This is used for Core Event Bus.
+     *
+     * Handlers are kept in an immutable list replaced on every subscription (see Rcu): Dispatch and Flush read it without locks,
+     * while other threads subscribe, unsubscribe or dispatch. Unsubscribing is O(1): it turns the entry into a tombstone, skipped from then on
+     * (even by a dispatch in progress, ParallelSafe jobs check before every call), and the list is compacted once tombstones outnumber live handlers.
+     * A call already running when Unsubscribe returns still finishes: do not destroy a bound object while it may be handling an event.
+     * A handler added during a dispatch is called from the next one.
+     */
     template <typename Event>
     class StaticEventBus {
     public:
-        using HandlerFunc = void(*)(const Event&);
+        /**
+         * @brief A function, a bound member (HandlerFunc::Bind<&T::OnEvent>(this)) or a small lambda, see Delegate.
+         */
+        using HandlerFunc = Delegate<void(const Event&)>;
+        /**
+         * @brief Receives the events of one Flush as a contiguous span (or a span of one from Dispatch).
+         */
+        using BatchHandlerFunc = Delegate<void(std::span<const Event>)>;
+
+        /**
+         * @return The token to unsubscribe with, invalid if the bus is full (see SubscriptionTable).
+         */
+        static Subscription Subscribe(HandlerFunc func, HandlerConcurrency concurrency = HandlerConcurrency::Serial) {
+            return Add(func, concurrency == HandlerConcurrency::ParallelSafe ? &HandlerList::ParallelPlain : &HandlerList::Plain);
+        }
+
+        static Subscription Subscribe(BatchHandlerFunc func, HandlerConcurrency concurrency = HandlerConcurrency::Serial) {
+            return Add(func, concurrency == HandlerConcurrency::ParallelSafe ? &HandlerList::ParallelBatch : &HandlerList::Batch);
+        }
 
-        static void Subscribe(HandlerFunc func) {
-            handlers.push_back(func);
+        /**
+         * @return false if the token was stale or invalid.
+         */
+        static bool Unsubscribe(Subscription subscription) {
+            bool compact = false;
+            {
+                std::lock_guard<SpinLock> guard(handlersLock);
+                if (!subscriptions.Release(subscription)) return false;
+                const HandlerList* list = handlers.load(std::memory_order_relaxed);
+                compact = ++tombstones * 2 > list->Size();
+            }
+            if (compact) Update([](HandlerList&) {});
+            return true;
         }
 
+        /**
+         * @brief Calls every handler with event. ParallelSafe handlers run on the pool while the serial ones run here, then the call waits for them.
+         *
+         * Serial handlers run inside an Rcu read section: called from a fiber job, a handler calling ThreadPool::Wait blocks the worker
+         * (helping with other jobs) instead of suspending the fiber.
+         */
         static void Dispatch(const Event& event) {
-            for (auto handler : handlers)
-                handler(event);
+            WaitGroup wg;
+            //Outlives the jobs, they read it through a pointer.
+            const std::span<const Event> events(&event, 1);
+            {
+                Rcu::ReadGuard guard;
+                const HandlerList* list = handlers.load(std::memory_order_seq_cst);
+                if (!list) return;
+                FanOut(*list, wg, events);
+                for (const auto& entry : list->Plain) {
+                    if (IsLive(entry)) entry.Handler(event);
+                }
+                for (const auto& entry : list->Batch) {
+                    if (IsLive(entry)) entry.Handler(events);
+                }
+            }
+            //Outside the guard: a fiber job may resume elsewhere.
+            ThreadPool::Wait(wg);
+        }
+
+        /**
+         * @brief Queues the event for the next Flush, from any thread. Appends to a buffer of the calling thread, which keeps its capacity:
+         * no allocation once warmed up, and no contention with the other producers.
+         */
+        template<typename E>
+        static void Enqueue(E&& event) {
+            Buffer& buffer = GetLocalBuffer();
+            std::lock_guard<SpinLock> guard(buffer.Lock);
+            buffer.Events.emplace_back(std::forward<E>(event));
+        }
+
+        /**
+         * @brief Delivers the queued events, main thread only (Engine::Loop calls it through EventQueues::FlushAll).
+         *
+         * The buffers are gathered into one batch, in order of queueing for each thread: every batch handler gets it as a single span,
+         * then every plain handler is called per event. A ParallelSafe plain handler goes through the whole batch in its own job.
+         * Same restriction as Dispatch on waiting from a handler.
+         */
+        static void Flush() {
+            batch.clear();
+            {
+                std::lock_guard<SpinLock> guard(buffersLock);
+                for (auto& buffer : buffers) {
+                    std::lock_guard<SpinLock> bufferGuard(buffer->Lock);
+                    std::move(buffer->Events.begin(), buffer->Events.end(), std::back_inserter(batch));
+                    buffer->Events.clear();
+                }
+            }
+            if (batch.empty()) return;
+            WaitGroup wg;
+            const std::span<const Event> events(batch);
+            {
+                Rcu::ReadGuard guard;
+                const HandlerList* list = handlers.load(std::memory_order_seq_cst);
+                if (!list) return;
+                FanOut(*list, wg, events);
+                for (const auto& entry : list->Batch) {
+                    if (IsLive(entry)) entry.Handler(events);
+                }
+                for (const Event& event : events) {
+                    for (const auto& entry : list->Plain) {
+                        if (IsLive(entry)) entry.Handler(event);
+                    }
+                }
+            }
+            ThreadPool::Wait(wg);
         }
 
     private:
-        static inline std::vector<HandlerFunc> handlers;
+        struct Buffer {
+            SpinLock Lock;
+            std::vector<Event> Events;
+            std::atomic<bool> Owned{ true };
+        };
+        //Releases the thread's buffer when it exits, for the next thread to reuse (pool threads come and go on resize).
+        struct BufferClaim {
+            Buffer* Claimed = nullptr;
+            ~BufferClaim() {
+                if (Claimed) Claimed->Owned.store(false, std::memory_order_release);
+            }
+        };
+
+        template<typename F>
+        struct Entry {
+            F Handler;
+            uint32_t Slot;
+            uint32_t Generation;
+        };
+
+        struct HandlerList {
+            std::vector<Entry<HandlerFunc>> Plain;
+            std::vector<Entry<BatchHandlerFunc>> Batch;
+            std::vector<Entry<HandlerFunc>> ParallelPlain;
+            std::vector<Entry<BatchHandlerFunc>> ParallelBatch;
+
+            size_t Size() const noexcept {
+                return Plain.size() + Batch.size() + ParallelPlain.size() + ParallelBatch.size();
+            }
+        };
+
+        static inline std::atomic<const HandlerList*> handlers{ nullptr };
+        //Serialises the writers, readers never take it.
+        static inline SpinLock handlersLock;
+        static inline SubscriptionTable subscriptions;
+        static inline size_t tombstones = 0;
+        static inline SpinLock buffersLock;
+        static inline std::vector<std::unique_ptr<Buffer>> buffers;
+        static inline std::vector<Event> batch;
+        static inline thread_local BufferClaim localBuffer;
+
+        template<typename F>
+        static void Update(F&& change) {
+            {
+                std::lock_guard<SpinLock> guard(handlersLock);
+                const HandlerList* old = handlers.load(std::memory_order_relaxed);
+                auto list = old ? std::make_unique<HandlerList>(*old) : std::make_unique<HandlerList>();
+                if (tombstones > 0) {
+                    const auto dead = [](const auto& entry) { return !IsLive(entry); };
+                    std::erase_if(list->Plain, dead);
+                    std::erase_if(list->Batch, dead);
+                    std::erase_if(list->ParallelPlain, dead);
+                    std::erase_if(list->ParallelBatch, dead);
+                    tombstones = 0;
+                }
+                change(*list);
+                handlers.store(list.release(), std::memory_order_seq_cst);
+                if (old) Rcu::Retire(old);
+            }
+            Rcu::Reclaim();
+        }
+
+        template<typename F>
+        static Subscription Add(F func, std::vector<Entry<F>> HandlerList::* target) {
+            Subscription subscription;
+            Update([&](HandlerList& list) {
+                subscription = subscriptions.Acquire();
+                if (subscription.IsValid()) (list.*target).push_back({ func, subscription.Slot, subscription.Generation });
+            });
+            return subscription;
+        }
+
+        template<typename F>
+        static bool IsLive(const Entry<F>& entry) noexcept {
+            return subscriptions.IsLive(entry.Slot, entry.Generation);
+        }
+
+        //The jobs copy the entries, they do not read the list after the guard is released. events must outlive the wait on wg.
+        static void FanOut(const HandlerList& list, WaitGroup& wg, const std::span<const Event>& events) {
+            for (const auto& entry : list.ParallelBatch) {
+                if (!IsLive(entry)) continue;
+                ThreadPool::QueueJob(JobPriority::Critical, &wg, [entry, events = &events] {
+                    if (IsLive(entry)) entry.Handler(*events);
+                });
+            }
+            for (const auto& entry : list.ParallelPlain) {
+                if (!IsLive(entry)) continue;
+                ThreadPool::QueueJob(JobPriority::Critical, &wg, [entry, events = &events] {
+                    for (const Event& event : *events) {
+                        //Unsubscribed midway: stop before the next event.
+                        if (!IsLive(entry)) return;
+                        entry.Handler(event);
+                    }
+                });
+            }
+        }
+
+        static Buffer& GetLocalBuffer() {
+            if (localBuffer.Claimed) return *localBuffer.Claimed;
+            std::lock_guard<SpinLock> guard(buffersLock);
+            if (buffers.empty()) EventQueues::Register(&Flush);
+            for (auto& buffer : buffers) {
+                if (!buffer->Owned.load(std::memory_order_relaxed) && !buffer->Owned.exchange(true, std::memory_order_acquire))
+                    return *(localBuffer.Claimed = buffer.get());
+            }
+            buffers.push_back(std::make_unique<Buffer>());
+            return *(localBuffer.Claimed = buffers.back().get());
+        }
+    };
+
+    /**
+     * @brief A bus instance, for subsystems that need their own events without global statics (plugins, scenes...).
+     *
+     * Any type can be published, handlers are found by a key unique to the type in the program. On top of StaticEventBus:
+     * - Channels: a handler subscribed to a channel only receives events published on it, one subscribed to no channel receives every event of its type.
+     * - Priorities: higher runs first, equal priorities run in subscription order.
+     * - Consumption: a handler returning true stops the event, lower priorities do not see it.
+     *
+     * The handlers are kept sorted by type, channel and priority, in an immutable table rebuilt on subscription (see Rcu):
+     * Publish binary-searches the type and channel ranges and only walks the handlers that receive the event, without locks.
+     * Unsubscribing is O(1) like StaticEventBus, through a Subscription token.
+     * Handlers run on the publishing thread, the bus may be published to and subscribed to from any thread.
+     */
+    class EventBus final {
+    public:
+        /**
+         * @brief Type-erased handler, receives a pointer to the event. Returns true if it consumed the event.
+         */
+        using ErasedHandler = Delegate<bool(const void*)>;
+
+    private:
+        struct Entry {
+            uint64_t Channel;
+            int32_t Priority;
+            uint32_t Order;             // Subscription order, breaks ties between equal priorities.
+            ErasedHandler Handler;
+            uint32_t Slot;
+            uint32_t Generation;
+        };
+
+        struct TypeHandlers {
+            uint64_t Type;
+            std::vector<Entry> Entries;   // Sorted by channel, then priority (descending), then order.
+        };
+
+        struct Table {
+            std::vector<TypeHandlers> Types;    // Sorted by type.
+        };
+
+        std::atomic<const Table*> m_table{ nullptr };
+        //Serialises the writers, readers never take it.
+        SpinLock m_lock;
+        SubscriptionTable m_subscriptions;
+        size_t m_tombstones = 0;
+        size_t m_entryCount = 0;
+        uint32_t m_order = 0;
+
+        //Not TypeId: it is the same for same-named types of different anonymous namespaces, the handler would get the wrong type.
+        //Mutable so the linker cannot fold the instances of different types together.
+        template<typename E>
+        static inline char TypeTag = 0;
+
+        template<typename E>
+        static uint64_t TypeKey() noexcept {
+            return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&TypeTag<std::remove_cvref_t<E>>));
+        }
+
+        Subscription Add(uint64_t type, StringId channel, int32_t priority, ErasedHandler handler);
+        bool Publish(uint64_t type, StringId channel, const void* event) const;
+        size_t GetHandlerCount(uint64_t type) const;
+
+    public:
+        EventBus() = default;
+        EventBus(const EventBus&) = delete;
+        EventBus& operator=(const EventBus&) = delete;
+        /**
+         * @brief Nothing may publish or subscribe anymore.
+         */
+        ~EventBus();
+
+        /**
+         * @brief Subscribes a callable taking const E&, returning bool (true consumes the event) or void. It is stored in a Delegate (no heap).
+         * @param channel Only events published on this channel, or every event of type E if empty.
+         * @param priority Handlers with a higher priority run first.
+         * @return The token to unsubscribe with, invalid if the bus is full.
+         */
+        template<typename E, typename F>
+        Subscription Subscribe(F&& handler, StringId channel = {}, int32_t priority = 0) {
+            using Fn = std::decay_t<F>;
+            static_assert(std::is_invocable_v<const Fn&, const E&>, "The handler must take the event as const E&.");
+            return Add(TypeKey<E>(), channel, priority, ErasedHandler([handler = Fn(std::forward<F>(handler))](const void* event) {
+                if constexpr (std::is_convertible_v<std::invoke_result_t<const Fn&, const E&>, bool>) {
+                    return static_cast<bool>(handler(*static_cast<const E*>(event)));
+                }
+                else {
+                    handler(*static_cast<const E*>(event));
+                    return false;
+                }
+            }));
+        }
+
+        /**
+         * @brief Subscribes Method of object, which must outlive the subscription.
+         */
+        template<typename E, auto Method, typename T>
+        Subscription Subscribe(T* object, StringId channel = {}, int32_t priority = 0) {
+            return Subscribe<E>([object](const E& event) { return (object->*Method)(event); }, channel, priority);
+        }
+
+        /**
+         * @return false if the token was stale or invalid.
+         */
+        bool Unsubscribe(Subscription subscription);
+
+        /**
+         * @brief Calls the handlers of E for channel, by priority, until one consumes the event.
+         * Handlers run inside an Rcu read section: called from a fiber job, a handler calling ThreadPool::Wait blocks the worker instead of suspending the fiber.
+         * @return true if the event was consumed.
+         */
+        template<typename E>
+        bool Publish(const E& event, StringId channel = {}) const {
+            return Publish(TypeKey<E>(), channel, &event);
+        }
+
+        /**
+         * @brief Live handlers of E, on every channel.
+         */
+        template<typename E>
+        size_t GetHandlerCount() const {
+            return GetHandlerCount(TypeKey<E>());
+        }
     };
 
     struct OnUpdate {
+        uint64_t Frame = 0;
+    };
 
+    /**
+     * @brief Render stage of a frame, dispatched after its OnUpdate. With EngineConfig::PipelineDepth above 1 it runs on the pool,
+     * while the main thread already updates the next frame: read per-frame data from FrameSnapshot slots.
+     */
+    struct OnRender {
+        uint64_t Frame = 0;
     };
 
     struct OnStart {
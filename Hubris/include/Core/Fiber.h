@@ -0,0 +1,48 @@
+#pragma once
+#include <cstddef>
+
+namespace Hubris {
+    namespace Detail {
+        struct FiberContext;
+    }
+
+    /**
+     * @brief A user-mode execution context with its own stack (Windows fibers, ucontext on POSIX).
+     *
+     * Switching never goes through the kernel scheduler, but it is not free: swapcontext also saves and restores the signal mask,
+     * a sigprocmask system call per switch on POSIX (SwitchToFiber stays in user mode). Suspend a fiber to wait for work, not per item.
+     * A fiber may be resumed on a different thread than the one it was suspended on.
+     */
+    class Fiber final {
+    public:
+        using EntryPoint = void(*)(void* arg);
+
+        static constexpr size_t DefaultStackSize = 64 * 1024;
+
+        Fiber() noexcept = default;
+        Fiber(const Fiber&) = delete;
+        Fiber& operator=(const Fiber&) = delete;
+        ~Fiber();
+
+        /**
+         * @brief Allocates the stack, the fiber starts running entry(arg) on the first SwitchTo. entry must never return.
+         * @return false if the stack or the context could not be allocated.
+         */
+        bool Create(EntryPoint entry, void* arg, size_t stackSize = DefaultStackSize) noexcept;
+
+        bool IsValid() const noexcept { return m_context != nullptr; }
+
+        /**
+         * @brief Suspends the calling context and runs this fiber until it calls SwitchBack.
+         */
+        void SwitchTo() noexcept;
+
+        /**
+         * @brief Called from inside the fiber, returns to the context that last called SwitchTo.
+         */
+        void SwitchBack() noexcept;
+
+    private:
+        Detail::FiberContext* m_context = nullptr;
+    };
+}
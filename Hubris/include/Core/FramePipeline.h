@@ -0,0 +1,95 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "Core/ThreadPool.h"
+
+namespace Hubris {
+    /**
+     * @brief Overlaps the update of frame N + 1 (main thread) with the render stage of frame N (pool).
+     *
+     * The main thread calls BeginFrame, updates, then SubmitRender; the render stage runs the frames in order, one at a time, as a Critical job.
+     * At most Depth frames are in flight: BeginFrame waits (helping the pool) until the render of frame N - Depth has finished,
+     * so per-frame data in FrameSnapshot slots is never overwritten while still being rendered. Depth 1 renders inline, fully serial.
+     */
+    class FramePipeline final {
+    public:
+        static constexpr uint32_t MaxDepth = 3;
+
+        using RenderFunc = void(*)(uint64_t frame);
+
+    private:
+        RenderFunc m_render;
+        uint32_t m_depth = 1;
+        uint64_t m_frame = 0;                       // Frame being updated, main thread only.
+        WaitGroup m_inFlight[MaxDepth];             // Render of the frame in slot frame % MaxDepth.
+        std::atomic<uint64_t> m_submitted{ 0 };     // Frames handed to the render stage.
+        uint64_t m_nextRender = 0;                  // Owned by whoever runs the render stage.
+        std::atomic<bool> m_renderActive{ false };
+
+        void RenderStage();
+
+    public:
+        explicit FramePipeline(RenderFunc render = nullptr, uint32_t depth = 1) noexcept;
+        FramePipeline(const FramePipeline&) = delete;
+        FramePipeline& operator=(const FramePipeline&) = delete;
+
+        /**
+         * @brief Changes the number of frames in flight, clamped to [1, MaxDepth]. Waits for the frames in flight first.
+         */
+        void SetDepth(uint32_t depth);
+
+        /**
+         * @brief Waits until the snapshot slot of the next frame is free, and returns the frame number to update.
+         */
+        uint64_t BeginFrame();
+
+        /**
+         * @brief Hands the frame started by BeginFrame to the render stage. With depth 1 (or no workers), renders it before returning.
+         */
+        void SubmitRender();
+
+        /**
+         * @brief Waits for every submitted frame to be rendered.
+         */
+        void Flush();
+
+        uint32_t GetDepth() const noexcept { return m_depth; }
+
+        /**
+         * @brief The frame currently updated (or the next one, between SubmitRender and BeginFrame).
+         */
+        uint64_t GetFrame() const noexcept { return m_frame; }
+    };
+
+    /**
+     * @brief Per-frame copies of state shared between the update and render stages of a FramePipeline.
+     *
+     * The update writes the slot of the frame it updates, the render stage reads the slot of the frame it renders.
+     * A slot is reused every MaxDepth frames, after the pipeline guaranteed its render finished.
+     */
+    template<typename T>
+    class FrameSnapshot final {
+    private:
+        T m_slots[FramePipeline::MaxDepth] = {};
+    public:
+        /**
+         * @brief The slot of frame, holding whatever was written MaxDepth frames ago.
+         */
+        T& Write(uint64_t frame) noexcept {
+            return m_slots[frame % FramePipeline::MaxDepth];
+        }
+
+        /**
+         * @brief The slot of frame, first filled with a copy of the previous frame's (updates run in order, the previous one is complete).
+         */
+        T& WriteFromPrevious(uint64_t frame) {
+            T& slot = Write(frame);
+            if (frame > 0) slot = m_slots[(frame - 1) % FramePipeline::MaxDepth];
+            return slot;
+        }
+
+        const T& Read(uint64_t frame) const noexcept {
+            return m_slots[frame % FramePipeline::MaxDepth];
+        }
+    };
+}
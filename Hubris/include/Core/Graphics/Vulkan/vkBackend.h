@@ -106,7 +106,7 @@ namespace Hubris::Graphics::Vulkan {
             device.SparceBinding = features.sparseBinding;
             device.APIVersion = prop.apiVersion;
             //This is redundent but is used to detect raytracing specific extension, Remove if possible.
-            static const std::vector<const char*> requiredRTExtensions = {
+            static constexpr StringId requiredRTExtensions[] = {
                 // Required ray tracing extensions
                 VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME,
                 VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME,
@@ -115,6 +115,12 @@ namespace Hubris::Graphics::Vulkan {
                 VK_KHR_RAY_TRACING_PIPELINE_EXTENSION_NAME,
                 VK_KHR_SPIRV_1_4_EXTENSION_NAME
             };
+            //requiredExt is a runtime list (it is handed to vkCreateDevice), hash it once.
+            static const std::vector<StringId> requiredExtIds = []() {
+                std::vector<StringId> ids;
+                for (const char* name : requiredExt) ids.push_back(StringId::Hash(name));
+                return ids;
+            }();
 
             if(!device.GeometryShader){
                 Logger::Log("Device does not support Geometry Shader");
@@ -125,19 +131,23 @@ namespace Hubris::Graphics::Vulkan {
                 device.Score += 1000;
             }
 
-            std::set<std::string> requiredExtensions(requiredExt.begin(), requiredExt.end());
-            std::set<std::string> rtxExt(requiredRTExtensions.begin(), requiredRTExtensions.end());
-            int found = 0;
+            //One bit per extension, set when the device reports it.
+            uint64_t requiredFound = 0, rtxFound = 0;
             for(const auto& supportedExt : ext){
-                requiredExtensions.erase(supportedExt.extensionName);
-                rtxExt.erase(supportedExt.extensionName);
+                const StringId id = StringId::Hash(supportedExt.extensionName);
+                for (size_t i = 0; i < requiredExtIds.size(); ++i)
+                    if (requiredExtIds[i] == id) requiredFound |= 1ull << i;
+                for (size_t i = 0; i < std::size(requiredRTExtensions); ++i)
+                    if (requiredRTExtensions[i] == id) rtxFound |= 1ull << i;
             }
+            const bool rtxSupported = rtxFound == (1ull << std::size(requiredRTExtensions)) - 1;
+            const bool requiredSupported = requiredFound == (1ull << requiredExtIds.size()) - 1;
 
-            if(rtxExt.empty()){
+            if(rtxSupported){
                 device.RayTracingCapable = true;
                 device.Score += 1000;
             }
-            if(requiredExtensions.empty()){
+            if(requiredSupported){
                 device.Score +=1000;
                 device.ExtSupported = true;
             }
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include "Core/Utils.h"
+
+namespace Hubris {
+    class WaitGroup;
+
+    /**
+     * @brief Scheduling class of a job. Workers always take work from the highest priority lane that has some.
+     */
+    enum class JobPriority : unsigned char {
+        Critical,       // Needed for the current frame.
+        Normal,
+        Background,     // Streaming, asset decoding, shader compilation: may span several frames.
+        IO              // Blocking calls (file reads...), run by the IO threads if the pool has any, else like Background.
+    };
+
+    /**
+     * @brief A unit of work for the ThreadPool. One cache line, the callable is stored inline (no heap allocation).
+     *
+     * Jobs are recycled from per-thread pools by the ThreadPool, user code never creates them directly.
+     */
+    struct alignas(CacheLineSize) Job {
+        /**
+         * @brief Maximum size of a callable stored in a job. Capture large state by pointer or reference.
+         */
+        static constexpr size_t StorageSize = 40;
+
+        enum class Kind : unsigned char {
+            Normal,     // Runs on the worker's own stack.
+            Fiber,      // Runs on a pooled fiber, ThreadPool::Wait suspends it instead of blocking the worker.
+            Resume      // Internal, continues a suspended fiber.
+        };
+
+        void (*Invoke)(Job&) = nullptr;         // Runs then destroys the stored callable.
+        WaitGroup* Group = nullptr;             // Signaled (Done) after the job ran.
+        std::atomic<bool> InUse{ false };       // Owned by a pool slot until the job completes.
+        Kind Type = Kind::Normal;
+        JobPriority Priority = JobPriority::Normal;
+        uint32_t SubmitTime = 0;                // Microseconds, wrapping, set on submit while ThreadPool stats are enabled, 0 otherwise.
+        alignas(8) unsigned char Storage[StorageSize];
+
+        template<typename F>
+        static constexpr bool Fits = sizeof(std::decay_t<F>) <= StorageSize && alignof(std::decay_t<F>) <= 8;
+
+        /**
+         * @brief Moves the callable into the job's inline storage.
+         */
+        template<typename F>
+        void Set(F&& func) noexcept(std::is_nothrow_constructible_v<std::decay_t<F>, F>) {
+            using Fn = std::decay_t<F>;
+            static_assert(Fits<F>, "Job callable is too large, capture by pointer/reference or move state elsewhere.");
+            new(Storage) Fn(std::forward<F>(func));
+            Invoke = [](Job& self) {
+                Fn* fn = std::launder(reinterpret_cast<Fn*>(self.Storage));
+                (*fn)();
+                fn->~Fn();
+            };
+        }
+
+        void Run() {
+            Invoke(*this);
+        }
+    };
+    static_assert(sizeof(Job) == CacheLineSize, "Job is meant to fill exactly one cache line.");
+}
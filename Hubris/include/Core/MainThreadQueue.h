@@ -0,0 +1,115 @@
+#pragma once
+#include <chrono>
+#include <exception>
+#include <future>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "Core/Task.h"
+
+namespace Hubris {
+    /**
+     * @brief Work that must run on the main thread (window creation, event polling, surface creation...), posted from any thread.
+     *
+     * Posting is a single lock-free enqueue. The queue is drained by Engine::Loop at a fixed point of the frame, within a time budget:
+     * what does not fit runs during the next frame, in posting order. If the queue is full, posts spill over to a lock protected list
+     * until it has been drained, which keeps the posting order.
+     */
+    class MainThreadQueue final {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        /**
+         * @brief A queued call: Invoke(State) runs on the main thread, once.
+         */
+        struct Item {
+            void (*Invoke)(void* state) = nullptr;
+            void* State = nullptr;
+        };
+
+        static constexpr size_t Capacity = 1024;
+
+    private:
+        template<typename R, typename F>
+        struct CallState {
+            F Fn;
+            std::promise<R> Promise;
+        };
+
+    public:
+        /**
+         * @brief true on the thread that initialized the engine (the thread running static initialization).
+         */
+        static bool IsMainThread() noexcept;
+
+        /**
+         * @brief Queues a raw call, the state is owned by the callee.
+         */
+        static void Post(Item item) noexcept;
+
+        /**
+         * @brief Queues fn to run on the main thread during a later drain, even when called from the main thread. Allocates the closure.
+         */
+        template<typename F>
+        static void Post(F&& fn) {
+            using Fn = std::decay_t<F>;
+            Post(Item{ [](void* state) {
+                std::unique_ptr<Fn> call(static_cast<Fn*>(state));
+                (*call)();
+            }, new Fn(std::forward<F>(fn)) });
+        }
+
+        /**
+         * @brief Runs fn on the main thread and returns its result through a future.
+         *
+         * Called on the main thread, fn runs immediately: waiting on the future never deadlocks the loop.
+         * Exceptions thrown by fn are stored in the future.
+         */
+        template<typename F>
+        static auto Submit(F&& fn) -> std::future<std::invoke_result_t<std::decay_t<F>&>> {
+            using R = std::invoke_result_t<std::decay_t<F>&>;
+            using State = CallState<R, std::decay_t<F>>;
+            auto* state = new State{ std::forward<F>(fn), {} };
+            std::future<R> future = state->Promise.get_future();
+            const auto invoke = [](void* raw) {
+                std::unique_ptr<State> call(static_cast<State*>(raw));
+                try {
+                    if constexpr (std::is_void_v<R>) {
+                        call->Fn();
+                        call->Promise.set_value();
+                    }
+                    else {
+                        call->Promise.set_value(call->Fn());
+                    }
+                }
+                catch (...) {
+                    call->Promise.set_exception(std::current_exception());
+                }
+            };
+            if (IsMainThread()) invoke(state);
+            else Post(Item{ invoke, state });
+            return future;
+        }
+
+        /**
+         * @brief A task running fn on the main thread, for coroutines: co_await MainThreadQueue::Run(...) continues on the main thread.
+         * Use SwitchToThreadPool() to leave it again. The task is lazy, like every Task.
+         */
+        template<typename F>
+        static Task<std::invoke_result_t<std::decay_t<F>&>> Run(F fn) {
+            co_await SwitchToMainThread();
+            co_return fn();
+        }
+
+        /**
+         * @brief Runs the calls queued so far on the main thread, until the budget is spent. Calls posted meanwhile wait for the next drain.
+         * @return The number of calls run.
+         */
+        static size_t Drain(Clock::duration budget = Clock::duration::max());
+
+        /**
+         * @brief Approximate number of queued calls.
+         */
+        static size_t GetPendingCount() noexcept;
+    };
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+
+namespace Hubris {
+    /**
+     * @brief Read-copy-update: readers walk an immutable object published through an atomic pointer, without locks,
+     * writers publish a modified copy and Retire the old one, deleted by Reclaim once no reader can still hold it.
+     *
+     * Readers announce themselves with a ReadGuard: one store in a per-thread slot on entry and one on exit, no shared cache line is written.
+     * Writers are expected to be rare. Reclaim may be called from inside a ReadGuard (e.g. subscribing from a handler), it then keeps
+     * whatever the calling thread may be reading.
+     */
+    class Rcu final {
+        Rcu() = delete;
+
+        static void Defer(void* object, void(*destroy)(void*));
+    public:
+        /**
+         * @brief Marks the calling thread as reading until destroyed. Nests. Must be destroyed on the thread that created it:
+         * ThreadPool::Wait does not suspend a fiber job holding one (see IsReading), it helps with the pool's jobs in place instead.
+         */
+        class ReadGuard final {
+        public:
+            ReadGuard() noexcept;
+            ~ReadGuard();
+            ReadGuard(const ReadGuard&) = delete;
+            ReadGuard& operator=(const ReadGuard&) = delete;
+        };
+
+        /**
+         * @brief Deletes object once every reader that may have loaded it is done. Call after the replacement is published (seq_cst store or exchange).
+         */
+        template<typename T>
+        static void Retire(const T* object) {
+            Defer(const_cast<T*>(object), [](void* p) { delete static_cast<T*>(p); });
+        }
+
+        /**
+         * @brief Deletes the retired objects no reader can see anymore. Writers call it after Retire, it is cheap when nothing is retired.
+         */
+        static void Reclaim();
+
+        /**
+         * @brief true while the calling thread holds a ReadGuard.
+         */
+        static bool IsReading() noexcept;
+
+        /**
+         * @brief Objects retired and not deleted yet.
+         */
+        static size_t GetRetiredCount();
+    };
+}
@@ -0,0 +1,117 @@
+#pragma once
+#ifdef HBR_STRINGID
+#else
+#define HBR_STRINGID
+#include <stdint.h>
+#include <cstddef>
+#include <string_view>
+#include <functional>
+#include <compare>
+
+namespace Hubris {
+    /**
+     * @brief 64-bit FNV-1a hash, usable both at compile time and at runtime (both produce the same value).
+     * The empty string hashes to 0, the value of a default constructed StringId.
+     */
+    constexpr uint64_t HashString(std::string_view str) noexcept {
+        if (str.empty()) return 0;
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (char c : str) {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    /**
+     * @brief Compile-time id of a type: the hash of its name as spelled by the compiler. Stable run to run with the same compiler,
+     * unlike typeid or the address of a static, but not across compilers (each spells names its own way).
+     * Not unique for types of anonymous namespaces: every translation unit spells them "(anonymous namespace)::X", so two of them share an id.
+     */
+    template<typename T>
+    consteval uint64_t TypeId() noexcept {
+#if defined(_MSC_VER) && !defined(__clang__)
+        return HashString(__FUNCSIG__);
+#else
+        return HashString(__PRETTY_FUNCTION__);
+#endif
+    }
+
+    /**
+     * @brief A hashed string identifier. Comparing, copying and hashing a StringId is an integer operation.
+     *
+     * Literals are hashed at compile time:
+     * @code {.cpp}
+     * constexpr Hubris::StringId id = "VK_KHR_swapchain";
+     * @endcode
+     * Runtime strings go through StringId::Hash() (hash only) or StringId::Intern() (hash and store the characters once, so GetString() works).
+     * Both give the same id as the literal form. The empty string, in any form, is the empty id: StringId() == ""_sid.
+     */
+    class StringId final {
+    private:
+        uint64_t id = 0;
+
+        constexpr explicit StringId(uint64_t hash, std::nullptr_t) noexcept : id(hash) {}
+    public:
+        constexpr StringId() noexcept = default;
+
+        /**
+         * @brief Hashes a string literal at compile time. Runtime strings must use Hash() or Intern().
+         */
+        template<size_t N>
+        consteval StringId(const char (&literal)[N]) noexcept : id(HashString(std::string_view(literal, N - 1))) {}
+
+        /**
+         * @brief Hashes a runtime string without storing it.
+         */
+        [[nodiscard]] static constexpr StringId Hash(std::string_view str) noexcept {
+            return StringId(HashString(str), nullptr);
+        }
+
+        /**
+         * @brief Recreates a StringId from a value returned by Value(), e.g. when loaded from a cache.
+         */
+        [[nodiscard]] static constexpr StringId FromValue(uint64_t value) noexcept {
+            return StringId(value, nullptr);
+        }
+
+        /**
+         * @brief Hashes and stores the string in the global intern table, repeated strings are stored once. Thread-safe.
+         */
+        static StringId Intern(std::string_view str);
+
+        /**
+         * @brief Finds the string an id was interned from. Thread-safe.
+         * @return The interned characters (valid for the program's lifetime), or an empty view if the id was never interned.
+         */
+        static std::string_view Lookup(StringId id);
+
+        /**
+         * @brief Equivalent to StringId::Lookup(*this).
+         */
+        std::string_view GetString() const { return Lookup(*this); }
+
+        constexpr uint64_t Value() const noexcept { return id; }
+        constexpr bool IsEmpty() const noexcept { return id == 0; }
+
+        constexpr bool operator==(const StringId&) const noexcept = default;
+        constexpr auto operator<=>(const StringId&) const noexcept = default;
+    };
+
+    inline namespace Literals {
+        /**
+         * @brief Compile-time StringId literal: "Engine.log"_sid
+         */
+        consteval StringId operator""_sid(const char* str, size_t len) noexcept {
+            return StringId::FromValue(HashString(std::string_view(str, len)));
+        }
+    }
+}
+
+template<>
+struct std::hash<Hubris::StringId> {
+    size_t operator()(const Hubris::StringId& id) const noexcept {
+        return static_cast<size_t>(id.Value());
+    }
+};
+#endif
@@ -0,0 +1,259 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#if defined(__GNUC__) || defined(__clang__)
+// GCC/Clang specific
+#include <x86intrin.h>
+#elif defined(_MSC_VER)
+// MSVC specific
+#include <intrin.h>
+#endif
+#define HBR_X86_PAUSE
+#endif
+
+namespace Hubris {
+    /**
+     * @brief Tells the core we are spinning (frees pipeline resources for the SMT sibling, saves power).
+     */
+    inline void CpuRelax() noexcept {
+#if defined(HBR_X86_PAUSE)
+        _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        __asm__ __volatile__("yield");
+#endif
+    }
+
+    /**
+     * @brief Polls before parking in the primitives below. Most waits in a frame are short, a futex round trip is not.
+     */
+    inline constexpr unsigned int SyncSpinCount = 64;
+
+    /**
+     * @brief Spins with CpuRelax until ready() holds or the spin budget runs out.
+     * @return true if ready() held.
+     */
+    template<typename F>
+    inline bool SpinUntil(F&& ready, unsigned int spins = SyncSpinCount) noexcept {
+        for (unsigned int i = 0; i < spins; ++i) {
+            if (ready()) return true;
+            CpuRelax();
+        }
+        return ready();
+    }
+
+    /**
+     * @brief A test-and-test-and-set lock with exponential backoff, for very short critical sections.
+     *
+     * Satisfies Lockable, works with std::lock_guard and std::unique_lock.
+     */
+    class SpinLock final {
+    private:
+        std::atomic<bool> locked{ false };
+    public:
+        static constexpr unsigned int MaxBackoff = 64;
+
+        void lock() noexcept {
+            unsigned int backoff = 1;
+            while (locked.exchange(true, std::memory_order_acquire)) {
+                //Spin on a plain load, the cache line stays shared until the owner releases it.
+                while (locked.load(std::memory_order_relaxed)) {
+                    if (backoff <= MaxBackoff) {
+                        for (unsigned int i = 0; i < backoff; ++i) CpuRelax();
+                        backoff <<= 1;
+                    }
+                    else {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+        }
+
+        bool try_lock() noexcept {
+            return !locked.load(std::memory_order_relaxed) && !locked.exchange(true, std::memory_order_acquire);
+        }
+
+        void unlock() noexcept {
+            locked.store(false, std::memory_order_release);
+        }
+    };
+
+    /**
+     * @brief Counts outstanding tasks, any number of threads may wait for it to reach zero.
+     *
+     * The counter, and a lock bit guarding the continuation list, share one atomic word: Add and Done are a single atomic operation,
+     * waiters spin briefly and then park with std::atomic::wait.
+     * The group may be destroyed as soon as a waiter observed zero (Wait returned, IsDone() is true, or a continuation was resumed).
+     */
+    class WaitGroup final {
+    public:
+        /**
+         * @brief Intrusive continuation, resumed once by the Done() that brings the counter to zero.
+         *
+         * Used to suspend fibers and coroutines on a group without blocking their thread. The node must outlive the wait.
+         */
+        struct Waiter {
+            void (*Resume)(Waiter* self) = nullptr;
+            Waiter* Next = nullptr;
+        };
+    private:
+        static constexpr uint32_t Locked = 1u << 31;    // The continuation list is being modified.
+        static constexpr uint32_t CountMask = Locked - 1;
+
+        std::atomic<uint32_t> state{ 0 };       // Counter and Locked bit, zero once every task is done.
+        Waiter* waiters = nullptr;              // Guarded by the Locked bit.
+    public:
+        WaitGroup() = default;
+        WaitGroup(const WaitGroup&) = delete;
+        WaitGroup& operator=(const WaitGroup&) = delete;
+
+        // Increment the counter
+        void Add(int n) {
+            state.fetch_add(static_cast<uint32_t>(n), std::memory_order_relaxed);
+        }
+
+        // Decrement the counter, the last Done resumes the continuations and wakes the waiting threads
+        void Done() {
+            uint32_t current = state.load(std::memory_order_relaxed);
+            while (true) {
+                if ((current & CountMask) == 0) return;     // Unbalanced Done, nothing to signal.
+                if ((current & CountMask) > 1) {
+                    if (state.compare_exchange_weak(current, current - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+                        return;
+                    continue;
+                }
+                if (current & Locked) {
+                    //AddWaiter is pushing, it only takes a few instructions.
+                    CpuRelax();
+                    current = state.load(std::memory_order_relaxed);
+                    continue;
+                }
+                //Final decrement: keep the list locked until it is detached, waiters only return once the whole word is zero.
+                if (state.compare_exchange_weak(current, Locked, std::memory_order_acq_rel, std::memory_order_relaxed))
+                    break;
+            }
+            Waiter* ready = std::exchange(waiters, nullptr);
+            state.store(0, std::memory_order_release);
+            //Address only wake, like std::latch: the group may already be gone here.
+            state.notify_all();
+            while (ready) {
+                Waiter* next = ready->Next;
+                ready->Resume(ready);
+                ready = next;
+            }
+        }
+
+        // Registers a continuation for when the counter reaches zero. Returns false, without registering, if it already is zero.
+        bool AddWaiter(Waiter* waiter) {
+            uint32_t current = state.load(std::memory_order_acquire);
+            while (true) {
+                if ((current & CountMask) == 0) return false;
+                if (current & Locked) {
+                    CpuRelax();
+                    current = state.load(std::memory_order_acquire);
+                    continue;
+                }
+                if (state.compare_exchange_weak(current, current | Locked, std::memory_order_acquire, std::memory_order_relaxed))
+                    break;
+            }
+            waiter->Next = waiters;
+            waiters = waiter;
+            state.fetch_and(~Locked, std::memory_order_release);
+            return true;
+        }
+
+        // Returns true once every task tracked by the group is done
+        bool IsDone() const noexcept {
+            return state.load(std::memory_order_acquire) == 0;
+        }
+
+        // Wait for the counter to reach zero, any number of threads may wait
+        void Wait() const {
+            if (SpinUntil([this] { return IsDone(); })) return;
+            uint32_t current = state.load(std::memory_order_acquire);
+            while (current != 0) {
+                state.wait(current, std::memory_order_acquire);
+                current = state.load(std::memory_order_acquire);
+            }
+        }
+    };
+
+    /**
+     * @brief A manual-reset event: Wait blocks until Set is called, and keeps returning immediately until Reset.
+     */
+    class Event final {
+    private:
+        std::atomic<uint32_t> signaled{ 0 };
+        std::atomic<uint32_t> parked{ 0 };
+    public:
+        explicit Event(bool initiallySet = false) noexcept : signaled(initiallySet ? 1 : 0) {}
+        Event(const Event&) = delete;
+        Event& operator=(const Event&) = delete;
+
+        void Set() noexcept {
+            signaled.store(1, std::memory_order_release);
+            //Pairs with the increment in Wait: either we see the sleeper, or it sees the signal.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (parked.load(std::memory_order_relaxed)) signaled.notify_all();
+        }
+
+        void Reset() noexcept {
+            signaled.store(0, std::memory_order_relaxed);
+        }
+
+        bool IsSet() const noexcept {
+            return signaled.load(std::memory_order_acquire) != 0;
+        }
+
+        void Wait() noexcept {
+            if (SpinUntil([this] { return IsSet(); })) return;
+            parked.fetch_add(1, std::memory_order_seq_cst);
+            while (!IsSet()) signaled.wait(0, std::memory_order_acquire);
+            parked.fetch_sub(1, std::memory_order_relaxed);
+        }
+    };
+
+    /**
+     * @brief A counting semaphore. Release only makes a system call when a thread is parked in Acquire.
+     */
+    class Semaphore final {
+    private:
+        std::atomic<int32_t> count;
+        std::atomic<uint32_t> parked{ 0 };
+    public:
+        explicit Semaphore(int32_t initial = 0) noexcept : count(initial) {}
+        Semaphore(const Semaphore&) = delete;
+        Semaphore& operator=(const Semaphore&) = delete;
+
+        bool TryAcquire() noexcept {
+            int32_t current = count.load(std::memory_order_relaxed);
+            while (current > 0) {
+                if (count.compare_exchange_weak(current, current - 1, std::memory_order_acquire, std::memory_order_relaxed))
+                    return true;
+            }
+            return false;
+        }
+
+        void Acquire() noexcept {
+            if (SpinUntil([this] { return TryAcquire(); })) return;
+            parked.fetch_add(1, std::memory_order_seq_cst);
+            while (!TryAcquire()) count.wait(0, std::memory_order_relaxed);
+            parked.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        void Release(int32_t n = 1) noexcept {
+            count.fetch_add(n, std::memory_order_release);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (parked.load(std::memory_order_relaxed)) {
+                if (n == 1) count.notify_one();
+                else count.notify_all();
+            }
+        }
+
+        int32_t GetCount() const noexcept {
+            return count.load(std::memory_order_relaxed);
+        }
+    };
+}
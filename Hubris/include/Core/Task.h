@@ -0,0 +1,298 @@
+#pragma once
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <span>
+#include <utility>
+#include <variant>
+#include "Core/ThreadPool.h"
+
+namespace Hubris {
+    template<typename T = void>
+    class Task;
+
+    namespace Detail {
+        /**
+         * @brief Coroutine frame allocator, frames are recycled through per-thread size-class free lists.
+         */
+        void* AllocateFrame(size_t size);
+        void FreeFrame(void* frame, size_t size) noexcept;
+
+        /**
+         * @brief Queues a coroutine to be resumed on the main thread, through the MainThreadQueue.
+         */
+        void PostToMainThread(std::coroutine_handle<> handle) noexcept;
+
+        /**
+         * @brief Marks the Continuation of a task that has completed.
+         */
+        inline void* const TaskCompleted = reinterpret_cast<void*>(1);
+
+        struct TaskPromiseBase {
+            std::atomic<void*> Continuation{ nullptr };     // Awaiting coroutine, or TaskCompleted.
+            WaitGroup* Group = nullptr;                     // Signaled on completion when started with Task::Start.
+            bool Started = false;
+
+            struct FinalAwaiter {
+                bool await_ready() const noexcept { return false; }
+
+                template<typename Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> self) noexcept {
+                    TaskPromiseBase& promise = self.promise();
+                    WaitGroup* group = promise.Group;
+                    void* continuation = promise.Continuation.exchange(TaskCompleted, std::memory_order_acq_rel);
+                    //The owner may destroy the frame as soon as the group is signaled.
+                    if (group) group->Done();
+                    if (continuation) return std::coroutine_handle<>::from_address(continuation);
+                    return std::noop_coroutine();
+                }
+
+                void await_resume() const noexcept {}
+            };
+
+            std::suspend_always initial_suspend() const noexcept { return {}; }
+            FinalAwaiter final_suspend() const noexcept { return {}; }
+
+            static void* operator new(size_t size) {
+                return AllocateFrame(size);
+            }
+
+            static void operator delete(void* frame, size_t size) noexcept {
+                FreeFrame(frame, size);
+            }
+        };
+
+        template<typename T>
+        struct TaskPromise : TaskPromiseBase {
+            std::variant<std::monostate, T, std::exception_ptr> Result;
+
+            Task<T> get_return_object() noexcept;
+
+            template<typename U>
+            void return_value(U&& value) noexcept(std::is_nothrow_constructible_v<T, U>) {
+                Result.template emplace<1>(std::forward<U>(value));
+            }
+
+            void unhandled_exception() noexcept {
+                Result.template emplace<2>(std::current_exception());
+            }
+
+            T& GetResult() & {
+                if (Result.index() == 2) std::rethrow_exception(std::get<2>(Result));
+                return std::get<1>(Result);
+            }
+
+            T&& GetResult() && {
+                if (Result.index() == 2) std::rethrow_exception(std::get<2>(Result));
+                return std::move(std::get<1>(Result));
+            }
+        };
+
+        template<>
+        struct TaskPromise<void> : TaskPromiseBase {
+            std::exception_ptr Exception;
+
+            Task<void> get_return_object() noexcept;
+
+            void return_void() noexcept {}
+
+            void unhandled_exception() noexcept {
+                Exception = std::current_exception();
+            }
+
+            void GetResult() const {
+                if (Exception) std::rethrow_exception(Exception);
+            }
+        };
+    }
+
+    /**
+     * @brief A lazily started coroutine producing a T.
+     *
+     * A task does not run until it is co_awaited or started with Start(). Awaiting an unstarted task runs it inline (symmetric transfer),
+     * awaiting a started one suspends the caller until it completes, and the caller then continues on the thread that completed it.
+     * Frames come from a per-thread pool (see Detail::AllocateFrame), a task does not touch the global heap once the pools are warm.
+     *
+     * The Task object owns the frame: it must outlive the coroutine's execution.
+     */
+    template<typename T>
+    class [[nodiscard]] Task {
+    public:
+        using promise_type = Detail::TaskPromise<T>;
+        using handle_type = std::coroutine_handle<promise_type>;
+
+    private:
+        handle_type m_handle;
+
+    public:
+        Task() noexcept = default;
+        explicit Task(handle_type handle) noexcept : m_handle(handle) {}
+
+        Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+
+        Task& operator=(Task&& other) noexcept {
+            if (this != &other) {
+                if (m_handle) m_handle.destroy();
+                m_handle = std::exchange(other.m_handle, nullptr);
+            }
+            return *this;
+        }
+
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+
+        ~Task() {
+            if (m_handle) m_handle.destroy();
+        }
+
+        bool IsValid() const noexcept { return static_cast<bool>(m_handle); }
+
+        /**
+         * @brief True once the coroutine ran to completion, the result can then be read with GetResult().
+         */
+        bool IsDone() const noexcept {
+            return m_handle && m_handle.promise().Continuation.load(std::memory_order_acquire) == Detail::TaskCompleted;
+        }
+
+        /**
+         * @brief Starts the task on a pool worker without awaiting it. Does nothing if the task was already started.
+         * @param wg Optional WaitGroup: Add(1) now, Done() when the task completes.
+         */
+        void Start(WaitGroup* wg = nullptr) {
+            promise_type& promise = m_handle.promise();
+            if (promise.Started) return;
+            promise.Started = true;
+            promise.Group = wg;
+            if (wg) wg->Add(1);
+            ThreadPool::QueueJob(nullptr, [handle = m_handle] { handle.resume(); });
+        }
+
+        /**
+         * @brief The value returned by the coroutine, rethrows its exception if it threw. Only valid once IsDone().
+         */
+        decltype(auto) GetResult() & { return m_handle.promise().GetResult(); }
+        decltype(auto) GetResult() && { return std::move(m_handle.promise()).GetResult(); }
+
+        /**
+         * @brief Awaiting an rvalue task moves its result out, awaiting an lvalue returns a reference to it.
+         */
+        template<bool MoveResult>
+        struct Awaiter {
+            handle_type Handle;
+
+            bool await_ready() const noexcept {
+                return Handle.promise().Continuation.load(std::memory_order_acquire) == Detail::TaskCompleted;
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                promise_type& promise = Handle.promise();
+                if (!promise.Started) {
+                    promise.Started = true;
+                    promise.Continuation.store(awaiting.address(), std::memory_order_relaxed);
+                    return Handle;
+                }
+                void* expected = nullptr;
+                if (promise.Continuation.compare_exchange_strong(expected, awaiting.address(), std::memory_order_acq_rel, std::memory_order_acquire))
+                    return std::noop_coroutine();
+                //Completed in the meantime.
+                return awaiting;
+            }
+
+            decltype(auto) await_resume() {
+                if constexpr (MoveResult) return std::move(Handle.promise()).GetResult();
+                else return Handle.promise().GetResult();
+            }
+        };
+
+        Awaiter<true> operator co_await() && noexcept { return Awaiter<true>{ m_handle }; }
+        Awaiter<false> operator co_await() & noexcept { return Awaiter<false>{ m_handle }; }
+    };
+
+    namespace Detail {
+        template<typename T>
+        Task<T> TaskPromise<T>::get_return_object() noexcept {
+            return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+        }
+
+        inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+            return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+        }
+    }
+
+    /**
+     * @brief co_await wg suspends the coroutine until the group reaches zero, it then continues on a pool worker.
+     */
+    struct WaitGroupAwaiter : WaitGroup::Waiter {
+        WaitGroup& Group;
+        std::coroutine_handle<> Handle;
+
+        explicit WaitGroupAwaiter(WaitGroup& group) noexcept : Group(group) {}
+
+        bool await_ready() const noexcept { return Group.IsDone(); }
+
+        bool await_suspend(std::coroutine_handle<> handle) {
+            Handle = handle;
+            Resume = [](WaitGroup::Waiter* self) {
+                ThreadPool::QueueJob(nullptr, [handle = static_cast<WaitGroupAwaiter*>(self)->Handle] { handle.resume(); });
+            };
+            return Group.AddWaiter(this);
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    inline WaitGroupAwaiter operator co_await(WaitGroup& wg) noexcept {
+        return WaitGroupAwaiter(wg);
+    }
+
+    struct ThreadPoolAwaiter {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) {
+            ThreadPool::QueueJob(nullptr, [handle] { handle.resume(); });
+        }
+        void await_resume() const noexcept {}
+    };
+
+    struct MainThreadAwaiter {
+        bool await_ready() const noexcept;
+        void await_suspend(std::coroutine_handle<> handle) noexcept {
+            Detail::PostToMainThread(handle);
+        }
+        void await_resume() const noexcept {}
+    };
+
+    /**
+     * @brief co_await SwitchToThreadPool() continues the coroutine on a pool worker.
+     */
+    [[nodiscard]] inline ThreadPoolAwaiter SwitchToThreadPool() noexcept { return {}; }
+
+    /**
+     * @brief co_await SwitchToMainThread() continues the coroutine on the main thread, during the next Engine::Loop. No-op on the main thread.
+     */
+    [[nodiscard]] inline MainThreadAwaiter SwitchToMainThread() noexcept { return {}; }
+
+    /**
+     * @brief Runs everything queued on the main thread so far (coroutines waiting in SwitchToMainThread included), without a time budget.
+     * Same as MainThreadQueue::Drain(), only call it yourself when driving the loop manually.
+     * @return The number of calls run.
+     */
+    size_t ResumeMainThreadTasks();
+
+    /**
+     * @brief Starts every task on the pool and completes once all of them did. Results are read from the tasks afterwards.
+     * The tasks must not have been started or awaited yet.
+     */
+    template<typename... Ts>
+    Task<void> WhenAll(Task<Ts>&... tasks) {
+        WaitGroup wg;
+        (tasks.Start(&wg), ...);
+        co_await wg;
+    }
+
+    template<typename T>
+    Task<void> WhenAll(std::span<Task<T>> tasks) {
+        WaitGroup wg;
+        for (Task<T>& task : tasks) task.Start(&wg);
+        co_await wg;
+    }
+}
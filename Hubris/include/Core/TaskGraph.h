@@ -0,0 +1,114 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <vector>
+#include "Core/StringId.h"
+#include "Core/ThreadPool.h"
+
+namespace Hubris {
+    /**
+     * @brief A dependency graph of jobs, compiled once and executed (typically every frame) on the ThreadPool.
+     *
+     * Dependencies are either explicit (AddEdge) or derived from the resources a node reads and writes, in registration order:
+     * a reader runs after the previous writer of the resource, a writer runs after the previous writer and every reader since.
+     * Compile() orders the graph and ranks each node by its critical path (own cost plus the most expensive chain after it).
+     * During Execute() ready nodes are started highest rank first, and a worker finishing a node continues directly with its highest ranked successor.
+     */
+    class TaskGraph final {
+    public:
+        using NodeId = uint32_t;
+
+        static constexpr NodeId InvalidNode = static_cast<NodeId>(-1);
+
+        enum class Result {
+            Success,
+            Cycle,          // The dependencies are cyclic, the graph cannot run.
+            InvalidArgument
+        };
+
+    private:
+        struct Node {
+            StringId Name;
+            std::function<void()> Work;
+            uint32_t Cost = 1;
+            std::vector<StringId> Reads;
+            std::vector<StringId> Writes;
+        };
+
+        std::vector<Node> m_nodes;
+        std::vector<std::pair<NodeId, NodeId>> m_explicitEdges;
+
+        //Compiled state.
+        std::vector<uint32_t> m_successorOffsets;   // Successors of i are m_successors[m_successorOffsets[i] .. m_successorOffsets[i + 1]), highest rank first.
+        std::vector<NodeId> m_successors;
+        std::vector<uint32_t> m_predecessorCounts;
+        std::vector<uint64_t> m_ranks;
+        std::vector<NodeId> m_roots;                // Highest rank first.
+        std::vector<NodeId> m_order;                // A topological order.
+        std::unique_ptr<std::atomic<uint32_t>[]> m_pending;
+        WaitGroup m_group;
+        bool m_compiled = false;
+
+        void QueueNode(NodeId node);
+        void RunNode(NodeId node);
+
+    public:
+        TaskGraph() = default;
+        TaskGraph(const TaskGraph&) = delete;
+        TaskGraph& operator=(const TaskGraph&) = delete;
+
+        /**
+         * @brief Registers a node. Changes to the graph take effect at the next Compile (Execute compiles if needed).
+         * @param name Debug name of the node.
+         * @param work The work to run, once per Execute.
+         * @param reads Resources the node only reads.
+         * @param writes Resources the node modifies.
+         * @param cost Relative cost estimate, used to find the critical path.
+         */
+        NodeId AddNode(StringId name, std::function<void()> work,
+            std::initializer_list<StringId> reads = {}, std::initializer_list<StringId> writes = {}, uint32_t cost = 1);
+
+        /**
+         * @brief Declares that after may only start once before has finished.
+         */
+        Result AddEdge(NodeId before, NodeId after);
+
+        Result Reads(NodeId node, StringId resource);
+        Result Writes(NodeId node, StringId resource);
+
+        /**
+         * @brief Derives the edges, orders the graph and computes the critical path ranks.
+         */
+        Result Compile();
+
+        /**
+         * @brief Runs every node once on the pool and returns when all finished, the calling thread helps meanwhile.
+         *
+         * Compiles the graph first if it changed. Must not be called again before it returned.
+         */
+        Result Execute();
+
+        /**
+         * @brief Removes every node and edge.
+         */
+        void Clear();
+
+        size_t GetNodeCount() const noexcept { return m_nodes.size(); }
+        bool IsCompiled() const noexcept { return m_compiled; }
+
+        /**
+         * @brief Cost of the most expensive dependency chain, the lower bound of Execute with unlimited workers. 0 if not compiled.
+         */
+        uint64_t GetCriticalPathCost() const noexcept;
+
+        /**
+         * @brief A topological order of the nodes, empty if not compiled.
+         */
+        const std::vector<NodeId>& GetOrder() const noexcept { return m_order; }
+
+        StringId GetName(NodeId node) const noexcept { return node < m_nodes.size() ? m_nodes[node].Name : StringId(); }
+    };
+}
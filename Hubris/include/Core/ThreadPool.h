@@ -1,60 +1,123 @@
 #pragma once
 #include <vector>
 #include <atomic>
-#include <condition_variable>
-#include <mutex>
-#if defined(__GNUC__) || defined(__clang__)
-// GCC/Clang specific
-#include <x86intrin.h>   // or <arm_neon.h> depending on architecture
-#elif defined(_MSC_VER)
-// MSVC specific
-#include <intrin.h>
-#endif
-
-#include <atomic>
-#include <condition_variable>
 #include <thread>
 #include <functional>
+#include <utility>
+#include "Core/Utils.h"
+#include "Core/Sync.h"
+#include "Core/Job.h"
 
 namespace Hubris {
-    class WaitGroup final {
-    private:
-        std::atomic<int> count{ 0 };            // Counter for tracking the number of tasks
-        std::mutex mtx;                         // Mutex for coordinating condition variable
-        std::condition_variable cv;             // Condition variable for wait signaling
-        std::atomic<bool> waiting{ false };     // Flag to prevent multiple waits
-    public:
-        WaitGroup() = default;
+    struct JobFiber;
+
+    /**
+     * @brief Threads that can get a physical core of their own, kept free of workers.
+     */
+    enum class ReservedCore : uint8_t {
+        Main,
+        Render,
+        IO
+    };
+
+    struct ThreadPoolConfig {
+        /**
+         * @brief Pin every worker to one logical CPU, spread over physical cores first (see CpuTopology::GetSpreadOrder).
+         */
+        bool PinThreads = true;
+        bool ReserveMainCore = true;
+        bool ReserveRenderCore = false;
+        bool ReserveIOCore = false;
+        /**
+         * @brief Threads running JobPriority::IO jobs, on top of the workers. They mostly block in system calls, so they do not take a core of their own
+         * (they share the reserved IO core if there is one). With 0, IO jobs run on the workers' Background lane.
+         */
+        unsigned int IOThreadCount = 0;
+    };
 
-        // Increment the counter
-        void Add(int n) {
-            count.fetch_add(n, std::memory_order_relaxed);
+    /**
+     * @brief Scheduler counters of one thread, see ThreadPool::GetStats. Only recorded while stats are enabled.
+     */
+    struct WorkerStats {
+        /**
+         * @brief Submit-to-start latency histogram: bucket 0 counts jobs started within a microsecond, bucket b in [2^(b-1), 2^b) microseconds, the last one everything slower.
+         */
+        static constexpr size_t LatencyBuckets = 16;
+
+        uint64_t JobsRun = 0;
+        uint64_t StealAttempts = 0;         // Victim deques probed.
+        uint64_t Steals = 0;                // Probes that returned a job.
+        uint64_t IdleNanoseconds = 0;       // Time without work, parked time included.
+        uint64_t ParkedNanoseconds = 0;
+        uint64_t Latency[LatencyBuckets] = {};
+        size_t QueuedJobs = 0;              // Jobs waiting in the worker's deques when sampled, not cumulative.
+
+        WorkerStats& operator+=(const WorkerStats& other) noexcept {
+            JobsRun += other.JobsRun;
+            StealAttempts += other.StealAttempts;
+            Steals += other.Steals;
+            IdleNanoseconds += other.IdleNanoseconds;
+            ParkedNanoseconds += other.ParkedNanoseconds;
+            for (size_t b = 0; b < LatencyBuckets; ++b) Latency[b] += other.Latency[b];
+            QueuedJobs += other.QueuedJobs;
+            return *this;
         }
 
-        // Decrement the counter and notify waiting threads if it reaches zero
-        void Done() {
-            if (count.fetch_sub(1, std::memory_order_acq_rel) == 1) {
-                std::lock_guard<std::mutex> lock(mtx);
-                cv.notify_all();  // Notify waiting threads
-            }
+        /**
+         * @brief The counters accumulated since an earlier sample of the same thread (QueuedJobs is kept).
+         */
+        WorkerStats& operator-=(const WorkerStats& earlier) noexcept {
+            JobsRun -= earlier.JobsRun;
+            StealAttempts -= earlier.StealAttempts;
+            Steals -= earlier.Steals;
+            IdleNanoseconds -= earlier.IdleNanoseconds;
+            ParkedNanoseconds -= earlier.ParkedNanoseconds;
+            for (size_t b = 0; b < LatencyBuckets; ++b) Latency[b] -= earlier.Latency[b];
+            return *this;
         }
 
-        // Wait for the counter to reach zero, usually called by the main thread
-        void Wait() {
-            bool expected = false;
-            if (!waiting.compare_exchange_strong(expected, true)) {
-                throw std::runtime_error("Only one thread can wait at a time.");
+        /**
+         * @brief Upper bound, in microseconds, of the latency under which the given fraction of the jobs started. 0 if no latency was recorded.
+         */
+        uint64_t GetLatencyPercentile(double fraction) const noexcept {
+            uint64_t total = 0;
+            for (uint64_t count : Latency) total += count;
+            if (total == 0) return 0;
+            uint64_t seen = 0;
+            for (size_t b = 0; b < LatencyBuckets; ++b) {
+                seen += Latency[b];
+                if (static_cast<double>(seen) >= fraction * static_cast<double>(total)) return uint64_t(1) << b;
             }
-            std::unique_lock<std::mutex> lock(mtx);
-            cv.wait(lock, [&] { return count.load(std::memory_order_acquire) == 0; });
-
-            // Reset the waiting flag after the wait is done, out of precaution.
-            waiting.store(false, std::memory_order_release);
+            return uint64_t(1) << (LatencyBuckets - 1);
         }
     };
 
+    struct ThreadPoolStats {
+        std::vector<WorkerStats> Workers;
+        WorkerStats External;               // Jobs run by other threads (helping in Wait, IO threads, inline fallbacks). Idle time is not tracked.
+        size_t InjectedJobs = 0;            // Jobs waiting in the injection queues when sampled.
+        size_t IOQueuedJobs = 0;
+        uint64_t TimeNanoseconds = 0;       // steady_clock time of the sample.
 
+        WorkerStats GetTotal() const noexcept {
+            WorkerStats total = External;
+            for (const WorkerStats& worker : Workers) total += worker;
+            return total;
+        }
+    };
 
+    /**
+     * @brief The engine's job system: a fixed set of worker threads, each owning a Chase-Lev work-stealing deque.
+     *
+     * Jobs queued from a worker go to the bottom of its own deque, jobs queued from any other thread go through a shared MPMC injection queue.
+     * A worker runs its own jobs first (newest first), then the injection queue, then steals the oldest jobs of other workers.
+     * Idle workers spin briefly and then park until new work is queued.
+     *
+     * Every priority has its own deques and injection queue (see JobPriority): a worker looks for Critical work everywhere before it touches
+     * a Normal job, and Normal before Background. So that a steady stream of frame work cannot starve the lower lanes,
+     * one search in StarvationInterval starts from the lowest lane.
+     * Workers about to park advance the TimerWheel, due timers are queued as jobs.
+     */
     class ThreadPool final {
     private:
         /**
@@ -65,31 +128,197 @@ namespace Hubris {
 		* @brief The threads in the pool.
 		*/
 		static inline std::vector<std::thread> Threads;
-    public:
-        static void InitalizePool(unsigned int threadCount =  std::thread::hardware_concurrency() - 1) {
-			ThreadCount = std::min(threadCount, std::thread::hardware_concurrency() - 1);
-            Logger::Log("{} Threads Allocated", ThreadCount);
-			for (unsigned int i = 0; i < ThreadCount; i++) {
-				Threads.emplace_back([]() {
-					while (true) {
-						// Wait for a task to be assigned
-						// Execute the task
-					}
-				});
-			}
+        /**
+         * @brief The number of IO threads, and the threads themselves.
+         */
+        static inline unsigned int IOThreadCount;
+        static inline std::vector<std::thread> IOThreads;
+        /**
+         * @brief Workers currently looking for work (spinning or parked).
+         */
+        static inline std::atomic<unsigned int> IdleWorkers{ 0 };
+
+        /**
+         * @brief Takes a free job slot from the calling thread's job pool, nullptr if every slot is in flight.
+         */
+        static Job* AllocateJob() noexcept;
+        /**
+         * @brief Pushes the job to the calling worker's deque, or to the injection queue from other threads. Runs it inline if both are full.
+         */
+        static void Submit(Job* job) noexcept;
+        /**
+         * @brief Runs the job according to its Job::Kind: on the calling stack, on a pooled fiber, or by resuming the fiber it belongs to.
+         */
+        static void Execute(Job* job) noexcept;
+        /**
+         * @brief Runs a job on the calling stack, releases its slot and signals its WaitGroup.
+         */
+        static void RunJob(Job* job) noexcept;
+        static void WorkerMain(unsigned int index);
+        static void IOThreadMain(unsigned int index);
+        static void RecordStart(const Job* job) noexcept;
+
+        /**
+         * @brief Takes a fiber from the shared fiber pool, creating one if the pool is below its limit. nullptr if none is available.
+         */
+        static JobFiber* AcquireFiber() noexcept;
+        /**
+         * @brief Switches to the fiber until it finishes its job or suspends in Wait, then recycles it or parks it on the WaitGroup.
+         */
+        static void RunFiber(JobFiber* fiber) noexcept;
+        static void FiberMain(void* arg);
+
+        template<typename F>
+        static void Enqueue(Job::Kind kind, JobPriority priority, WaitGroup* wg, F&& job) {
+            Job* j = AllocateJob();
+            if (!j) {
+                job();
+                return;
+            }
+            j->Set(std::forward<F>(job));
+            j->Type = kind;
+            j->Priority = priority;
+            j->Group = wg;
+            if (wg) wg->Add(1);
+            Submit(j);
         }
+    public:
+        /**
+         * @brief A worker takes from the lower lanes first once every StarvationInterval searches.
+         */
+        static constexpr unsigned int StarvationInterval = 64;
+
+        /**
+         * @brief Starts the workers. The count is clamped to the logical CPUs left once the reserved cores are taken out.
+         * 
+         * With PinThreads, each worker is pinned to its own logical CPU and steals from the closest workers first (same core, same L3, same NUMA node...).
+         * Like Shutdown, it must not race with other threads using the pool.
+         */
+        static void InitalizePool(unsigned int threadCount =  std::thread::hardware_concurrency() - 1, const ThreadPoolConfig& config = {});
+
+        /**
+         * @brief Pins the calling thread to the core reserved for role.
+         * @return false if the core was not reserved or pinning is disabled or unsupported.
+         */
+        static bool PinToReservedCore(ReservedCore role);
+
+        /**
+         * @brief Lets the workers finish the queued jobs, then joins them. Safe to call more than once.
+         *
+         * Frees the worker array: no thread outside the pool may be using it meanwhile (in Wait, RunPendingJob, GetStats, GetThreadCount...),
+         * asserted in debug builds. ThreaddingServer::ApplyResize restarts the pool between frames, on the main thread, for that reason.
+         */
+        static void Shutdown();
 
         /**
          * @brief Queues a job to be executed by the threadpool, it may get executed by any thread in the pool.
          * 
-         * (planned behaviour)
-         * If wg is not null, the job is wrapped in a lambda that handles calling WaitGroup.Add() and WaitGroup.Done() appropriately.
+         * If wg is not null, WaitGroup::Add(1) is called before the job is queued and WaitGroup::Done() after it ran.
+         * 
+         * The callable is stored inline in the job (see Job::StorageSize), queueing never allocates.
+         * If the calling thread has too many jobs in flight, or the queues are full, the job runs immediately on the calling thread.
          * 
-         * @param wg This argument is here to support the upcoming (and completed) waitgroup  
+         * @param wg Optional WaitGroup tracking the job's completion.
          * @param job the job to be added to the Queue, it may execute on any thread in the pool.
          */
-        static void QueueJob(WaitGroup* wg, std::function<void()> job){
+        template<typename F>
+        static void QueueJob(WaitGroup* wg, F&& job){
+            Enqueue(Job::Kind::Normal, JobPriority::Normal, wg, std::forward<F>(job));
+        }
+
+        /**
+         * @brief Same as QueueJob, in the given priority lane.
+         */
+        template<typename F>
+        static void QueueJob(JobPriority priority, WaitGroup* wg, F&& job) {
+            Enqueue(Job::Kind::Normal, priority, wg, std::forward<F>(job));
+        }
 
+        /**
+         * @brief Same as QueueJob, but the job runs on its own fiber: ThreadPool::Wait inside it suspends the job and frees the worker for other work.
+         * 
+         * Use it for jobs that wait on other jobs (dependency chains), plain leaf jobs are cheaper with QueueJob.
+         * The fiber stack is small (Fiber::DefaultStackSize), keep large buffers off it.
+         * When every pooled fiber is busy, the job runs like a normal job and its waits fall back to helping.
+         */
+        template<typename F>
+        static void QueueFiberJob(WaitGroup* wg, F&& job) {
+            Enqueue(Job::Kind::Fiber, JobPriority::Normal, wg, std::forward<F>(job));
+        }
+
+        template<typename F>
+        static void QueueFiberJob(JobPriority priority, WaitGroup* wg, F&& job) {
+            Enqueue(Job::Kind::Fiber, priority, wg, std::forward<F>(job));
+        }
+
+        /**
+         * @brief Waits for the WaitGroup to reach zero.
+         * 
+         * Inside a fiber job, the job is suspended and resumed (possibly on another worker) by the last Done().
+         * Anywhere else, queued jobs run on the calling thread meanwhile, and it parks like an idle worker once none are left.
+         * Background jobs are only picked up once no other work was found for a while, a long decode should not land on a thread waiting for frame work.
+         * Prefer this over WaitGroup::Wait() from inside a job: a worker blocked in WaitGroup::Wait() is a worker lost to the pool.
+         */
+        static void Wait(WaitGroup& wg);
+
+        /**
+         * @brief Runs one queued job on the calling thread if there is any.
+         * @return true if a job ran.
+         */
+        static bool RunPendingJob();
+
+        /**
+         * @brief The number of worker threads in the pool (the calling thread is not counted).
+         */
+        static unsigned int GetThreadCount() noexcept {
+            return ThreadCount;
         }
+
+        /**
+         * @brief The number of IO threads (see ThreadPoolConfig::IOThreadCount).
+         */
+        static unsigned int GetIOThreadCount() noexcept {
+            return IOThreadCount;
+        }
+
+        /**
+         * @brief Number of workers that found no work on their last attempt. A hint for adaptive splitting, it may be stale by the time it is read.
+         */
+        static unsigned int GetIdleWorkerCount() noexcept {
+            return IdleWorkers.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Starts or stops recording the scheduler counters (see WorkerStats). Off by default, it costs two clock reads per job.
+         */
+        static void EnableStats(bool enable) noexcept;
+        static bool IsStatsEnabled() noexcept;
+
+        /**
+         * @brief Samples the counters of every thread, and the current queue depths. The counters only grow, subtract two samples to get an interval.
+         */
+        static ThreadPoolStats GetStats();
+
+        /**
+         * @brief Logs a summary of the counters since the previous call: jobs, steals, idle share and latency percentiles per worker.
+         * Meant to be called once per frame (see EngineConfig::DumpSchedulerStats).
+         */
+        static void LogStats();
+
+        /**
+         * @brief Index of the calling worker in [0, GetThreadCount()), or -1 if the caller is not a pool thread.
+         */
+        static int GetWorkerIndex() noexcept;
+
+        /**
+         * @brief Slot of the calling thread in per-thread storage (see WorkerLocal): workers first, then IO threads,
+         * and the last one shared by every thread outside the pool.
+         */
+        static unsigned int GetLocalSlot() noexcept;
+
+        /**
+         * @brief Workers + IO threads + 1, as of the last InitalizePool.
+         */
+        static unsigned int GetLocalSlotCount() noexcept;
     };
 }
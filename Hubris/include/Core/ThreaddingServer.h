@@ -2,13 +2,115 @@
 #ifdef HBR_THREADSRV
 #else
 #define HBR_THREADSRV
+#include <memory>
+#include "Core/ThreadPool.h"
+#include "Core/FramePipeline.h"
+
 namespace Hubris::Core {
-	class ThreaddingServer {
-		ThreaddingServer() = default;
+	/**
+	 * @brief Runs the engine's jobs: starts and stops the threads behind the ThreadPool API.
+	 */
+	class ThreadingBackend {
 	public:
-		virtual ~ThreaddingServer() = 0;
-		virtual void Initialize(unsigned int Tcount) = 0;
-		virtual void Shutdown() = 0;
+		virtual ~ThreadingBackend() = default;
+		virtual const char* GetName() const noexcept = 0;
+		virtual void Start(unsigned int workerCount, const ThreadPoolConfig& config) = 0;
+		/**
+		 * @brief Runs the queued jobs to completion and joins the threads.
+		 */
+		virtual void Stop() = 0;
+		virtual unsigned int GetWorkerCount() const noexcept = 0;
+		/**
+		 * @brief false if every job runs inline when queued, in program order.
+		 */
+		virtual bool IsConcurrent() const noexcept = 0;
+	};
+
+	/**
+	 * @brief The work-stealing pool: workers, and the IO threads if configured.
+	 */
+	class ThreadPoolBackend final : public ThreadingBackend {
+	public:
+		const char* GetName() const noexcept override { return "ThreadPool"; }
+		void Start(unsigned int workerCount, const ThreadPoolConfig& config) override;
+		void Stop() override;
+		unsigned int GetWorkerCount() const noexcept override { return ThreadPool::GetThreadCount(); }
+		bool IsConcurrent() const noexcept override { return true; }
+	};
+
+	/**
+	 * @brief No threads at all: the pool is not started, so jobs run on the thread queueing them, immediately and in order.
+	 * Frames are reproducible run to run, for replays, tests and debugging.
+	 */
+	class DeterministicBackend final : public ThreadingBackend {
+	public:
+		const char* GetName() const noexcept override { return "Deterministic"; }
+		void Start(unsigned int, const ThreadPoolConfig&) override {}
+		void Stop() override {}
+		unsigned int GetWorkerCount() const noexcept override { return 0; }
+		bool IsConcurrent() const noexcept override { return false; }
+	};
+
+	/**
+	 * @brief Owns the engine's threads and their lifetime: the workers and IO threads (through the backend), the main thread's core and dispatch queue,
+	 * and the render stage of the frame pipeline.
+	 *
+	 * Startup: backend, then the main thread is pinned. Shutdown, in order: frames in flight are rendered, the main thread queue is drained,
+	 * the backend runs the remaining jobs and joins its threads, then whatever those jobs posted to the main thread runs.
+	 * Unless a backend was set explicitly, a thread count of 0 selects the DeterministicBackend and any other count the ThreadPoolBackend.
+	 */
+	class ThreaddingServer final {
+		static inline std::unique_ptr<ThreadingBackend> Backend;
+		static inline bool CustomBackend = false;
+		static inline ThreadPoolConfig Config;
+		static inline FramePipeline* Pipeline = nullptr;
+		static inline bool Running = false;
+		static constexpr unsigned int NoResize = ~0u;
+		static inline std::atomic<unsigned int> RequestedCount{ NoResize };   // Set by Resize, applied by ApplyResize.
+
+		ThreaddingServer() = delete;
+
+		static void SelectBackend(unsigned int Tcount);
+		/**
+		 * @brief Waits for the frames in flight and runs the main thread's queue: nothing is left half done when the backend stops.
+		 */
+		static void Quiesce();
+	public:
+		/**
+		 * @brief Starts the threads. Must be called on the main thread.
+		 * @param Tcount Worker threads, 0 for the deterministic backend.
+		 * @param pipeline Frame pipeline flushed before the threads stop, may be null.
+		 */
+		static void Initialize(unsigned int Tcount, const ThreadPoolConfig& config = {}, FramePipeline* pipeline = nullptr);
+
+		/**
+		 * @brief Stops every thread, in order. Safe to call more than once.
+		 */
+		static void Shutdown();
+
+		/**
+		 * @brief Requests a new number of workers while the engine runs, e.g. to follow a container CPU quota. Callable from any thread, jobs included.
+		 *
+		 * Only records the count: the resize happens at the next ApplyResize (Engine::Loop, before the frame starts), never on the caller's stack.
+		 * The last request wins. Threads the engine does not own must not use the ThreadPool while it is applied, see ThreadPool::Shutdown.
+		 * @return false if the server is not running.
+		 */
+		static bool Resize(unsigned int Tcount);
+
+		/**
+		 * @brief Applies the count requested by Resize, if any: the frames in flight finish, the main thread queue is drained,
+		 * the backend stops and restarts with the new count (0 switches to the deterministic backend).
+		 * Main thread only, between frames: not from a job, a handler or a MainThreadQueue call.
+		 */
+		static void ApplyResize();
+
+		/**
+		 * @brief Replaces the automatic backend choice. Takes effect immediately if the server is running (the old backend is stopped first).
+		 */
+		static void SetBackend(std::unique_ptr<ThreadingBackend> backend);
+
+		static ThreadingBackend* GetBackend() noexcept { return Backend.get(); }
+		static bool IsRunning() noexcept { return Running; }
 	};
 }
 #endif
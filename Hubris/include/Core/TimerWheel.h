@@ -0,0 +1,124 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+#include "Core/Sync.h"
+#include "Core/ThreadPool.h"
+
+namespace Hubris {
+    /**
+     * @brief Delayed and periodic jobs, kept in a hierarchical timing wheel (Levels wheels of SlotCount slots, intrusive lists).
+     *
+     * Scheduling and cancelling are O(1). Nothing sleeps: the wheel is advanced by whoever services it (Engine::Loop every frame,
+     * pool workers running out of work) and due timers are queued on the ThreadPool as jobs of their priority.
+     * Timers fire at the first Advance at or after their deadline, rounded up to the resolution.
+     * A periodic timer is rescheduled from its previous deadline, so it does not drift; if the callback is slower than the period, runs may overlap.
+     */
+    class TimerWheel final {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr uint32_t SlotBits = 8;
+        static constexpr uint32_t SlotCount = 1u << SlotBits;
+        static constexpr uint32_t Levels = 4;       // Deadlines up to SlotCount^Levels ticks ahead (about 49 days at 1ms), further ones are clamped.
+
+        /**
+         * @brief Identifies a scheduled timer. Stale ids (fired or cancelled timers) are detected, the slot may be reused safely.
+         */
+        struct TimerId {
+            uint32_t Index = Invalid;
+            uint32_t Generation = 0;
+
+            static constexpr uint32_t Invalid = static_cast<uint32_t>(-1);
+            bool IsValid() const noexcept { return Index != Invalid; }
+        };
+
+    private:
+        static constexpr uint32_t Null = static_cast<uint32_t>(-1);
+        static constexpr uint32_t SlotMask = SlotCount - 1;
+
+        struct Timer {
+            std::shared_ptr<std::function<void()>> Callback;  // Shared with the queued runs of a periodic timer.
+            uint64_t Deadline = 0;      // In ticks.
+            uint64_t Period = 0;        // In ticks, 0 for one shot timers.
+            uint32_t Prev = Null;
+            uint32_t Next = Null;
+            uint32_t Generation = 0;
+            uint16_t Slot = 0;          // Level * SlotCount + slot, to unlink without searching.
+            JobPriority Priority = JobPriority::Normal;
+            bool Active = false;
+        };
+
+        struct Due {
+            std::shared_ptr<std::function<void()>> Callback;
+            JobPriority Priority;
+        };
+
+        SpinLock m_lock;
+        std::vector<Timer> m_timers;
+        uint32_t m_freeList = Null;                 // Chained through Timer::Next.
+        uint32_t m_slots[Levels * SlotCount];       // Heads of the slot lists.
+        uint64_t m_current = 0;                     // Last tick processed.
+        size_t m_activeCount = 0;
+        Clock::time_point m_origin;
+        Clock::duration m_resolution;
+        std::atomic<bool> m_advancing{ false };
+        std::vector<Due> m_due;                     // Used by the advancing thread only.
+
+        uint64_t ToTicks(Clock::duration duration) const noexcept;
+        void Link(uint32_t index) noexcept;
+        void Unlink(uint32_t index) noexcept;
+        void Release(uint32_t index) noexcept;
+        void Expire(uint32_t index);
+        void Cascade(uint32_t level, uint32_t slot);
+        TimerId Insert(Clock::duration delay, Clock::duration period, std::shared_ptr<std::function<void()>> callback, JobPriority priority);
+
+    public:
+        explicit TimerWheel(Clock::duration resolution = std::chrono::milliseconds(1));
+        TimerWheel(const TimerWheel&) = delete;
+        TimerWheel& operator=(const TimerWheel&) = delete;
+
+        /**
+         * @brief The wheel serviced by the engine and the ThreadPool workers.
+         */
+        static TimerWheel& Get();
+
+        /**
+         * @brief Runs fn once, as a job, after the delay.
+         */
+        template<typename F>
+        TimerId Schedule(Clock::duration delay, F&& fn, JobPriority priority = JobPriority::Normal) {
+            return Insert(delay, Clock::duration::zero(), std::make_shared<std::function<void()>>(std::forward<F>(fn)), priority);
+        }
+
+        /**
+         * @brief Runs fn as a job every period, the first time one period from now, until cancelled.
+         */
+        template<typename F>
+        TimerId SchedulePeriodic(Clock::duration period, F&& fn, JobPriority priority = JobPriority::Normal) {
+            return Insert(period, period, std::make_shared<std::function<void()>>(std::forward<F>(fn)), priority);
+        }
+
+        /**
+         * @brief Removes a pending timer. Runs already queued are not recalled.
+         * @return false if the timer already fired (one shot) or was cancelled.
+         */
+        bool Cancel(TimerId id);
+
+        /**
+         * @brief Processes every tick up to now and queues the due timers. Returns immediately if another thread is advancing the wheel.
+         * @return The number of timers queued.
+         */
+        size_t Advance(Clock::time_point now = Clock::now());
+
+        /**
+         * @brief The number of pending timers.
+         */
+        size_t GetTimerCount();
+
+        Clock::duration GetResolution() const noexcept { return m_resolution; }
+    };
+}
@@ -4,6 +4,10 @@
 // #define NDEBUG
 #include <assert.h>
 #include <atomic>
+#include <array>
+#include <algorithm>
+#include <new>
+#include <utility>
 #include <type_traits>
 
 //
@@ -55,6 +59,13 @@ static inline uint32_t rotr32(uint32_t n, unsigned int c)
 }
 namespace Hubris{
 
+    /**
+     * @brief Assumed size of a cache line, used to pad shared atomics apart to avoid false sharing.
+     * 
+     * std::hardware_destructive_interference_size is not used as its value can differ between translation units.
+     */
+    inline constexpr size_t CacheLineSize = 64;
+
     /**
      * @brief An implementation of a fixed-size (power of two only) Ring Buffer.
      * @tparam T The Buffer's underlying type.
@@ -70,8 +81,8 @@ namespace Hubris{
         static_assert((!std::is_array_v<T>), "Cannot store arrays in the ring buffer. Although, support maybe added if a need ever arises.");
         //Fixed-size
         std::array<T, buffsize> buffer;
-        std::atomic<size_t> head{ 0 };				// Head (dequeue pointer)
-        std::atomic<size_t> tail{ 0 };				// Tail (enqueue pointer)
+        alignas(CacheLineSize) std::atomic<size_t> head{ 0 };	// Head (dequeue pointer)
+        alignas(CacheLineSize) std::atomic<size_t> tail{ 0 };	// Tail (enqueue pointer)
         const size_t mask = buffsize - 1;	// Mask used for fast wrap-around
     public:
         /**
@@ -135,4 +146,191 @@ namespace Hubris{
             return (current_tail - current_head) & mask;
         }
     };
+
+    /**
+     * @brief A fixed-size (power of two only) bounded Multi-Producer/Multi-Consumer queue.
+     * 
+     * Every slot carries a sequence number that tells producers and consumers whether the slot is free for the current lap,
+     * so threads only contend on the index they move (no locks, no shared "count").
+     * The enqueue and dequeue indices live on separate cache lines.
+     * 
+     * Elements are constructed in place in the slot and moved out on dequeue.
+     * @tparam T The Queue's underlying type.
+     * @tparam buffsize The queue capacity, must be a power of two.
+     */
+    template<typename T, size_t buffsize>
+    class MPMCQueue {
+    private:
+        static_assert((buffsize > 1) && ((buffsize & (buffsize - 1)) == 0),
+            "Buffer size must be a power of 2 (and greater than 1) to gain performance.");
+        static_assert((!std::is_abstract_v<T>), "Abstract types can cause issues.");
+        static_assert((!std::is_array_v<T>), "Cannot store arrays in the queue.");
+        static_assert(std::is_nothrow_move_assignable_v<T>, "Elements are moved out of the queue inside a noexcept context.");
+
+        struct Slot {
+            std::atomic<size_t> sequence;
+            alignas(T) unsigned char storage[sizeof(T)];
+
+            T* Get() noexcept { return std::launder(reinterpret_cast<T*>(storage)); }
+        };
+
+        static constexpr size_t mask = buffsize - 1;	// Mask used for fast wrap-around
+
+        std::array<Slot, buffsize> buffer;
+        alignas(CacheLineSize) std::atomic<size_t> tail{ 0 };	// Enqueue position
+        alignas(CacheLineSize) std::atomic<size_t> head{ 0 };	// Dequeue position
+        //Keeps whatever follows the queue off the head's cache line.
+        char padding[CacheLineSize - sizeof(std::atomic<size_t>)];
+
+        static intptr_t Distance(size_t seq, size_t pos) noexcept {
+            return static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        }
+
+        /**
+         * @brief Claims up to count contiguous slots starting at the index, the slots at [pos, pos+n) are owned by the caller on return.
+         * @param index The index to advance (head or tail).
+         * @param lap 0 for producers (slot must be empty for this lap), 1 for consumers (slot must be filled).
+         * @return The number of claimed slots, pos is set to the first claimed position.
+         */
+        size_t Claim(std::atomic<size_t>& index, size_t count, size_t lap, size_t& pos) noexcept {
+            pos = index.load(std::memory_order_relaxed);
+            while (true) {
+                const intptr_t diff = Distance(buffer[pos & mask].sequence.load(std::memory_order_acquire), pos + lap);
+                if (diff < 0) {
+                    // Full (producers) or empty (consumers).
+                    return 0;
+                }
+                if (diff > 0) {
+                    // Another thread claimed this position, catch up.
+                    pos = index.load(std::memory_order_relaxed);
+                    continue;
+                }
+                // Extend the claim over the following slots that are ready for the same lap.
+                size_t n = 1;
+                while (n < count && buffer[(pos + n) & mask].sequence.load(std::memory_order_acquire) == pos + n + lap)
+                    ++n;
+                if (index.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed))
+                    return n;
+            }
+        }
+
+    public:
+        /**
+         * @brief Evaluated at compile time, returns the size of the buffer which is already known.
+         */
+        constexpr size_t Capacity()const noexcept { return buffsize; };
+
+        MPMCQueue() noexcept {
+            for (size_t i = 0; i < buffsize; ++i)
+                buffer[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        ~MPMCQueue() noexcept {
+            if constexpr (!std::is_trivially_destructible_v<T>) {
+                size_t pos;
+                while (Claim(head, 1, 1, pos))
+                    buffer[pos & mask].Get()->~T();
+            }
+        }
+
+        MPMCQueue(const MPMCQueue&) = delete;
+        MPMCQueue& operator=(const MPMCQueue&) = delete;
+
+        /**
+         * @brief Constructs an element in place at the tail of the queue. The constructor must not throw: the slot is claimed first,
+         * an element never published would stall every consumer behind it.
+         * @return false if the queue is full, the arguments are left untouched in that case.
+         */
+        template<typename ...Args>
+        bool Emplace(Args&& ...args) noexcept {
+            static_assert(std::is_nothrow_constructible_v<T, Args...>, "The element is constructed in a claimed slot, it must not throw.");
+            size_t pos;
+            if (!Claim(tail, 1, 0, pos)) return false;
+            Slot& slot = buffer[pos & mask];
+            new(slot.storage) T(std::forward<Args>(args)...);
+            slot.sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Enqueue element into the queue, returns false if the queue is full
+        bool Enqueue(const T& element) noexcept {
+            return Emplace(element);
+        }
+
+        // Enqueue element into the queue, returns false if the queue is full
+        bool Enqueue(T&& element) noexcept {
+            return Emplace(std::move(element));
+        }
+
+        /**
+         * @brief Enqueues up to count elements with a single index update.
+         * 
+         * The elements enqueued are kept contiguous in the queue, so a consumer draining with DequeueN receives them in order.
+         * @param first Iterator to the first element, elements are copied (use std::make_move_iterator to move them). Like Emplace, it must not throw.
+         * @return The number of elements enqueued (the first n of the range), 0 if the queue is full.
+         */
+        template<typename InputIt>
+        size_t EnqueueN(InputIt first, size_t count) noexcept {
+            static_assert(std::is_nothrow_constructible_v<T, decltype(*first)>, "The elements are constructed in claimed slots, it must not throw.");
+            if (count == 0) return 0;
+            size_t pos;
+            const size_t n = Claim(tail, std::min(count, buffsize), 0, pos);
+            for (size_t i = 0; i < n; ++i, ++first) {
+                Slot& slot = buffer[(pos + i) & mask];
+                new(slot.storage) T(*first);
+                slot.sequence.store(pos + i + 1, std::memory_order_release);
+            }
+            return n;
+        }
+
+        // Dequeue element from the queue, returns false if the queue is empty
+        bool Dequeue(T& element) noexcept {
+            size_t pos;
+            if (!Claim(head, 1, 1, pos)) return false;
+            Slot& slot = buffer[pos & mask];
+            T* item = slot.Get();
+            element = std::move(*item);
+            item->~T();
+            slot.sequence.store(pos + buffsize, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Dequeues up to max elements with a single index update.
+         * @param out Output iterator receiving the elements (moved), assigning through it must not throw (no back_inserter: write into a sized buffer).
+         * @return The number of elements dequeued, 0 if the queue is empty.
+         */
+        template<typename OutputIt>
+        size_t DequeueN(OutputIt out, size_t max) noexcept {
+            static_assert(std::is_nothrow_assignable_v<decltype(*out), T&&>, "The elements are moved out of claimed slots, it must not throw.");
+            if (max == 0) return 0;
+            size_t pos;
+            const size_t n = Claim(head, std::min(max, buffsize), 1, pos);
+            for (size_t i = 0; i < n; ++i, ++out) {
+                Slot& slot = buffer[(pos + i) & mask];
+                T* item = slot.Get();
+                *out = std::move(*item);
+                item->~T();
+                slot.sequence.store(pos + i + buffsize, std::memory_order_release);
+            }
+            return n;
+        }
+
+        // Returns true if the queue appears empty, only a snapshot when other threads are active.
+        inline bool IsEmpty() const noexcept {
+            return Size() == 0;
+        }
+
+        // Returns true if the queue appears full, only a snapshot when other threads are active.
+        inline bool IsFull() const noexcept {
+            return Size() >= buffsize;
+        }
+
+        // Returns the approximate number of elements in the queue.
+        inline size_t Size() const noexcept {
+            const size_t current_head = head.load(std::memory_order_acquire);
+            const size_t current_tail = tail.load(std::memory_order_acquire);
+            return current_tail > current_head ? current_tail - current_head : 0;
+        }
+    };
 }
\ No newline at end of file
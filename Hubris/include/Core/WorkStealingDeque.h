@@ -0,0 +1,103 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include "Core/Utils.h"
+
+namespace Hubris {
+    /**
+     * @brief A bounded Chase-Lev work-stealing deque of pointers.
+     *
+     * The owning thread pushes and pops at the bottom (LIFO, cache-warm work), any other thread steals from the top (FIFO, oldest work).
+     * Owner operations only synchronize with thieves when the deque is about to become empty.
+     * The memory orderings follow Lê, Pop, Cohen & Zappa Nardelli, "Correct and Efficient Work-Stealing for Weak Memory Models" (2013).
+     * @tparam T The pointee type.
+     * @tparam Capacity Maximum number of items, must be a power of two.
+     */
+    template<typename T, size_t Capacity>
+    class WorkStealingDeque {
+    private:
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two.");
+        static constexpr int64_t mask = static_cast<int64_t>(Capacity) - 1;
+
+        alignas(CacheLineSize) std::atomic<int64_t> top{ 0 };       // Steal end
+        alignas(CacheLineSize) std::atomic<int64_t> bottom{ 0 };    // Owner end
+        alignas(CacheLineSize) std::atomic<T*> buffer[Capacity];
+
+    public:
+        WorkStealingDeque() noexcept {
+            for (auto& slot : buffer) slot.store(nullptr, std::memory_order_relaxed);
+        }
+
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+        /**
+         * @brief Owner only. Pushes an item at the bottom.
+         * @return false if the deque is full.
+         */
+        bool Push(T* item) noexcept {
+            const int64_t b = bottom.load(std::memory_order_relaxed);
+            const int64_t t = top.load(std::memory_order_acquire);
+            if (b - t > mask) return false;
+            buffer[b & mask].store(item, std::memory_order_relaxed);
+            //Publishes the slot to thieves, pairs with the acquire load of bottom in Steal.
+            bottom.store(b + 1, std::memory_order_release);
+            return true;
+        }
+
+        /**
+         * @brief Owner only. Pops the most recently pushed item.
+         * @return nullptr if the deque is empty (or the last item was stolen concurrently).
+         */
+        T* Pop() noexcept {
+            const int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+            bottom.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = top.load(std::memory_order_relaxed);
+
+            if (t > b) {
+                //Empty.
+                bottom.store(b + 1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            T* item = buffer[b & mask].load(std::memory_order_relaxed);
+            if (t == b) {
+                //Last item, race the thieves for it.
+                if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    item = nullptr;
+                bottom.store(b + 1, std::memory_order_relaxed);
+            }
+            return item;
+        }
+
+        /**
+         * @brief Any thread. Takes the oldest item.
+         * @return nullptr if the deque is empty or another thread won the race for the item.
+         */
+        T* Steal() noexcept {
+            int64_t t = top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const int64_t b = bottom.load(std::memory_order_acquire);
+            if (t >= b) return nullptr;
+
+            T* item = buffer[t & mask].load(std::memory_order_relaxed);
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                return nullptr;
+            return item;
+        }
+
+        /**
+         * @brief Approximate number of items, only a hint when other threads are active.
+         */
+        size_t Size() const noexcept {
+            const int64_t b = bottom.load(std::memory_order_relaxed);
+            const int64_t t = top.load(std::memory_order_relaxed);
+            return b > t ? static_cast<size_t>(b - t) : 0;
+        }
+
+        bool IsEmpty() const noexcept { return Size() == 0; }
+
+        constexpr size_t GetCapacity() const noexcept { return Capacity; }
+    };
+}
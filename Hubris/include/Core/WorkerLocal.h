@@ -0,0 +1,103 @@
+#pragma once
+#include <vector>
+#include <utility>
+#include "Core/Utils.h"
+#include "Core/ThreadPool.h"
+
+namespace Hubris {
+    /**
+     * @brief Registration of a WorkerLocal with the ThreadPool, which sizes it to its threads every time the pool starts.
+     */
+    class WorkerLocalBase {
+        friend class ThreadPool;
+    private:
+        WorkerLocalBase* m_prev = nullptr;
+        WorkerLocalBase* m_next = nullptr;
+
+        virtual void Allocate(unsigned int slotCount) = 0;
+    protected:
+        WorkerLocalBase() = default;
+        ~WorkerLocalBase() = default;
+
+        /**
+         * @brief Links into the registry and allocates for the current pool. Called last by the derived constructor.
+         */
+        void Register();
+        /**
+         * @brief Called first by the derived destructor.
+         */
+        void Unregister();
+    public:
+        WorkerLocalBase(const WorkerLocalBase&) = delete;
+        WorkerLocalBase& operator=(const WorkerLocalBase&) = delete;
+    };
+
+    /**
+     * @brief One T per pool thread (see ThreadPool::GetLocalSlot), each on its own cache lines: jobs of a parallel pass accumulate into
+     * the slot of the thread running them without atomics or locks, and the slots are combined once the pass is over.
+     *
+     * Typical use is a member or a static of a system: per-thread histograms, draw lists, bounding boxes.
+     * Local() is only stable within a job: a fiber job may resume on another thread after a Wait and must call it again.
+     * The threads outside the pool share one slot, the main thread is expected to be the only one of them running passes.
+     * Every slot is reset to the initial value when the pool (re)starts.
+     */
+    template<typename T>
+    class WorkerLocal final : public WorkerLocalBase {
+    private:
+        struct alignas(CacheLineSize) Slot {
+            T Value;
+        };
+
+        T m_init;
+        std::vector<Slot> m_slots;
+
+        void Allocate(unsigned int slotCount) override {
+            m_slots.assign(slotCount, Slot{ m_init });
+        }
+
+    public:
+        explicit WorkerLocal(T init = T{}) : m_init(std::move(init)) {
+            Register();
+        }
+
+        ~WorkerLocal() {
+            Unregister();
+        }
+
+        /**
+         * @brief The slot of the calling thread.
+         */
+        T& Local() noexcept {
+            return m_slots[ThreadPool::GetLocalSlot()].Value;
+        }
+
+        /**
+         * @brief Calls f(T&) on every slot. Not synchronised with Local(): only once the jobs writing the slots are done.
+         */
+        template<typename F>
+        void ForEach(F&& f) {
+            for (Slot& slot : m_slots) f(slot.Value);
+        }
+
+        /**
+         * @brief Folds every slot into a copy of the initial value: result = op(std::move(result), slot). Same constraint as ForEach.
+         */
+        template<typename Op>
+        T Combine(Op&& op) const {
+            T result = m_init;
+            for (const Slot& slot : m_slots) result = op(std::move(result), slot.Value);
+            return result;
+        }
+
+        /**
+         * @brief Sets every slot back to the initial value, typically after Combine, before the next pass.
+         */
+        void Reset() {
+            for (Slot& slot : m_slots) slot.Value = m_init;
+        }
+
+        unsigned int GetSlotCount() const noexcept {
+            return static_cast<unsigned int>(m_slots.size());
+        }
+    };
+}
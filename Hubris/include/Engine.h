@@ -2,6 +2,11 @@
 #include <Platform.h>
 #include <Logger.h>
 #include <Core/ThreadPool.h>
+#include <Core/Task.h>
+#include <Core/MainThreadQueue.h>
+#include <Core/TimerWheel.h>
+#include <Core/FramePipeline.h>
+#include <Core/TaskGraph.h>
 #include <Core/ThreaddingServer.h>
 #include <Core/Graphics/Window.h>
 #include <Memory.h>
@@ -24,9 +29,34 @@ namespace Hubris {
 	/// @brief Used to configure the engine on instantiation.
 	struct EngineConfig {
 		/**
-		 * @brief Maximum of Thread to be spawned. (default: std::thread::hardware_concurrency() - 1)
+		 * @brief Maximum of Thread to be spawned, 0 runs every job on the main thread, deterministically. (default: std::thread::hardware_concurrency() - 1)
 		 */
 		unsigned int ThreadCount = std::thread::hardware_concurrency() - 1;
+		/**
+		 * @brief Pin the main thread and the workers to their own logical CPUs, spread over physical cores and grouped by NUMA node. (default: true)
+		 */
+		bool PinThreads = true;
+		/**
+		 * @brief Keep a physical core free of workers for a dedicated render/IO thread, see ThreadPool::PinToReservedCore. The main thread always gets one.
+		 */
+		bool ReserveRenderCore = false;
+		bool ReserveIOCore = false;
+		/**
+		 * @brief Threads for blocking JobPriority::IO jobs, see ThreadPoolConfig::IOThreadCount. (default: 0)
+		 */
+		unsigned int IOThreadCount = 0;
+		/**
+		 * @brief Time Loop() may spend running calls posted to the MainThreadQueue, the rest waits for the next frame. (default: 2ms)
+		 */
+		std::chrono::microseconds MainThreadBudget = std::chrono::milliseconds(2);
+		/**
+		 * @brief Record the scheduler counters and log them after every frame, see ThreadPool::LogStats. (default: false)
+		 */
+		bool DumpSchedulerStats = false;
+		/**
+		 * @brief Frames in flight, up to FramePipeline::MaxDepth. Above 1, OnRender of frame N runs on the pool while OnUpdate of frame N + 1 runs. (default: 1)
+		 */
+		uint32_t PipelineDepth = 1;
 		RenderAPI GraphicsBackend = RenderAPI::Vulkan;
 		/**
 		* @brief Set to empty string to make the execution folder the root.
@@ -62,6 +92,10 @@ namespace Hubris {
 		static inline Graphics::Window* window;
 		static inline std::terminate_handler originalHandler = nullptr;
 		static inline std::vector<const char*> Env = std::vector<const char*>(0);
+		static inline TaskGraph FrameGraph;
+		static inline MainThreadQueue::Clock::duration MainThreadBudget = std::chrono::milliseconds(2);
+		static inline bool DumpSchedulerStats = false;
+		static inline FramePipeline Pipeline{ [](uint64_t frame) { Core::StaticEventBus<Core::OnRender>::Dispatch(Core::OnRender{ frame }); } };
 		static void InitGraphics(const EngineConfig& config);
 
 
@@ -106,7 +140,16 @@ namespace Hubris {
 				return;
 			}
 			ProjectName = config.ProjectName;
-			//ThreadPool::InitalizePool(config.ThreadCount);
+			MainThreadBudget = config.MainThreadBudget;
+			DumpSchedulerStats = config.DumpSchedulerStats;
+			Pipeline.SetDepth(config.PipelineDepth);
+			ThreadPoolConfig poolConfig;
+			poolConfig.PinThreads = config.PinThreads;
+			poolConfig.ReserveRenderCore = config.ReserveRenderCore;
+			poolConfig.ReserveIOCore = config.ReserveIOCore;
+			poolConfig.IOThreadCount = config.IOThreadCount;
+			Core::ThreaddingServer::Initialize(config.ThreadCount, poolConfig, &Pipeline);
+			ThreadPool::EnableStats(config.DumpSchedulerStats);
 			InitGraphics(config);
 
 			originalHandler = std::set_terminate(Engine::Terminate);
@@ -121,15 +164,21 @@ namespace Hubris {
 		/**
 		 * @brief Yields control to the engine logic. The Engine will run until the program exits. 
 		 * 
-		 * This Calls Loop() in a loop.
+		 * This Calls Loop() in a loop, then dispatches OnUpdate, executes the frame graph and hands the frame to the render stage (OnRender),
+		 * which overlaps with the next frame's update when EngineConfig::PipelineDepth is above 1.
 		 * 
 		 * @warning This requires the Engine to be initialized first.
 		 */
 		static void Run() {
 			while (window->IsRunning()) {
 				Loop();
-				Core::StaticEventBus<Core::OnUpdate>::Dispatch(Core::OnUpdate());
+				const uint64_t frame = Pipeline.BeginFrame();
+				Core::StaticEventBus<Core::OnUpdate>::Dispatch(Core::OnUpdate{ frame });
+				FrameGraph.Execute();
+				Pipeline.SubmitRender();
+				if (DumpSchedulerStats) ThreadPool::LogStats();
 			}
+			Core::ThreaddingServer::Shutdown();
 		}
 		/**
 		 * @brief The Engine Executes the main loop once, then returns control to user. 
@@ -137,7 +186,14 @@ namespace Hubris {
 		 * @warning This requires the Engine to be initialized first.
 		 */
 		static void Loop() {
+			//Between frames: nothing runs on the threads a requested resize restarts.
+			Core::ThreaddingServer::ApplyResize();
 			window->Update();
+			TimerWheel::Get().Advance();
+			//Thread-affine work posted by the workers (window, surface, presentation...).
+			MainThreadQueue::Drain(MainThreadBudget);
+			//Events queued during the previous frame, delivered in batches.
+			Core::EventQueues::FlushAll();
 // #pragma warning (push) 
 // #pragma warning (disable: 4996)
 // 			_sleep(100);
@@ -159,6 +215,18 @@ namespace Hubris {
 		}
 
 		static void CreateWindow() {}
+
+		/**
+		 * @brief The graph of systems executed on the thread pool every frame, after the OnUpdate event.
+		 * 
+		 * Register nodes with their resource reads/writes, independent systems run in parallel.
+		 */
+		static TaskGraph& GetFrameGraph() noexcept { return FrameGraph; }
+
+		/**
+		 * @brief The update/render pipeline driven by Run(), GetFrame() is the frame being updated.
+		 */
+		static const FramePipeline& GetFramePipeline() noexcept { return Pipeline; }
 		
 		static Graphics::Window* GetWindow() {};
 		static inline const std::string& GetProjectName() noexcept { return ProjectName; };
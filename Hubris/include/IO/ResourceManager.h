@@ -1,5 +1,6 @@
 #pragma once
 #include <filesystem>
+#include "Core/StringId.h"
 
 
 namespace Hubris::IO {
@@ -59,8 +60,8 @@ namespace Hubris::IO {
         // Must have Import(path)
         { T::Import(path) } -> std::same_as<std::shared_ptr<typename T::AssetType>>;
 
-        // Must have GetHandledType()
-        { T::GetHandledType() } -> std::same_as<std::string>;
+        // Must have GetHandledType(), returned as a StringId so handler lookup is an integer compare.
+        { T::GetHandledType() } -> std::same_as<StringId>;
     };
 
     class ResourceManager {
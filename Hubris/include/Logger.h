@@ -14,11 +14,12 @@
 #include "fmt/core.h"
 #include <fmt/std.h>
 #include <fmt/chrono.h>
+#include "Core/StringId.h"
 
 namespace Hubris {
     class Logger {
     private:
-        static inline std::unordered_map<std::string, FILE*> LogFiles;
+        static inline std::unordered_map<StringId, FILE*> LogFiles;
         static inline FILE* LogFile = nullptr;
     
         static std::string getCurrentTime() {
@@ -28,13 +29,13 @@ namespace Hubris {
             );
         }
 
-        static FILE* OpenAndReturn(std::string fileName){
+        static FILE* OpenAndReturn(const std::string& fileName, StringId key){
             FILE* f;
             errno_t err = fopen_s(&f, fileName.c_str(), "a+");
             if(err != 0){
                 std::cerr << "Logger: Error opening file " << fileName << std::endl;
             }
-            LogFiles[fileName] = f;
+            LogFiles[key] = f;
             return f;
         }
 
@@ -85,9 +86,10 @@ namespace Hubris {
          * @brief Logs in a file, if the file is used for the first time, it is opened and kept in cache.
          */
         template<typename ...Args>
-        static void FileLog(std::string fileName, const char* message, Args&& ...args){
-            FILE* file = LogFiles[fileName];
-            file = (file ? file : OpenAndReturn(fileName));
+        static void FileLog(const std::string& fileName, const char* message, Args&& ...args){
+            const StringId key = StringId::Hash(fileName);
+            FILE* file = LogFiles[key];
+            file = (file ? file : OpenAndReturn(fileName, key));
             std::cout << fmt::format(message, std::forward<Args>(args)...) << std::endl;
             fmt::println(file, "({})[ThreadID: {}] Fatal: {}", getCurrentTime(), std::this_thread::get_id(), fmt::format(message, std::forward<Args>(args)...));
         }
@@ -9,6 +9,9 @@ enum class Hbr_Platform : unsigned short {
 #if defined(WIN32) || defined(_WIN32) || defined(__WIN32__) || defined(__NT__)
     #define HBR_WINDOWS
     #define WIN32_LEAN_AND_MEAN 
+    #ifndef NOMINMAX
+    #define NOMINMAX    // <Windows.h> would otherwise turn std::min/std::max into its macros.
+    #endif
     //#include "Windows.h"
     return Hbr_Platform::Windows;
 #elif __APPLE__
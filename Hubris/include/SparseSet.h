@@ -0,0 +1,212 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+#include <type_traits>
+#include "List.h"
+
+namespace Hubris {
+    /**
+     * @brief Maps 32-bit keys (entity ids, object indices...) to values stored in a packed dense array.
+     *
+     * The sparse side is split in pages of PageSize indices that are allocated on first use, so large but sparse key ranges stay cheap.
+     * Membership tests and lookups are two array reads, erasure swaps the last element into the hole so the dense array never has gaps.
+     * Iterating dense() or keys() therefore touches only live elements, in contiguous memory.
+     *
+     * Like List<T>, this container does not throw: allocation failures are reported through return values.
+     * @tparam T The value type.
+     * @tparam PageSize Number of keys covered by one sparse page, must be a power of two.
+     */
+    template<typename T, size_t PageSize = 4096>
+    class SparseSet {
+    public:
+        using key_type = uint32_t;
+        using value_type = T;
+        using size_type = std::size_t;
+        using iterator = T*;
+        using const_iterator = const T*;
+
+        enum class Result {
+            Success,
+            OutOfMemory,
+            InvalidArgument
+        };
+
+        /**
+         * @brief Marks an empty sparse entry, also the one key that cannot be stored.
+         */
+        static constexpr key_type Tombstone = static_cast<key_type>(-1);
+
+    private:
+        static_assert(PageSize > 0 && (PageSize & (PageSize - 1)) == 0, "PageSize must be a power of two.");
+
+        List<key_type*> m_pages;
+        List<key_type> m_keys;      // dense index -> key
+        List<T> m_values;           // dense index -> value
+
+        static constexpr size_type PageOf(key_type key) noexcept { return key / PageSize; }
+        static constexpr size_type OffsetOf(key_type key) noexcept { return key & (PageSize - 1); }
+
+        key_type* page_for(key_type key) const noexcept {
+            const size_type p = PageOf(key);
+            return p < m_pages.size() ? m_pages[p] : nullptr;
+        }
+
+        key_type* assure_page(key_type key) noexcept {
+            const size_type p = PageOf(key);
+            if (p >= m_pages.size() && m_pages.resize(p + 1, nullptr) != List<key_type*>::Result::Success)
+                return nullptr;
+            if (!m_pages[p]) {
+                key_type* page = static_cast<key_type*>(std::malloc(PageSize * sizeof(key_type)));
+                if (!page) return nullptr;
+                for (size_type i = 0; i < PageSize; ++i) page[i] = Tombstone;
+                m_pages[p] = page;
+            }
+            return m_pages[p];
+        }
+
+        void free_pages() noexcept {
+            for (size_type i = 0; i < m_pages.size(); ++i) std::free(m_pages[i]);
+            m_pages.clear();
+        }
+
+    public:
+        SparseSet() noexcept = default;
+        SparseSet(const SparseSet&) = delete;
+        SparseSet& operator=(const SparseSet&) = delete;
+
+        SparseSet(SparseSet&& other) noexcept
+            : m_pages(std::move(other.m_pages)), m_keys(std::move(other.m_keys)), m_values(std::move(other.m_values)) {}
+
+        SparseSet& operator=(SparseSet&& other) noexcept {
+            if (this != &other) {
+                free_pages();
+                m_pages = std::move(other.m_pages);
+                m_keys = std::move(other.m_keys);
+                m_values = std::move(other.m_values);
+            }
+            return *this;
+        }
+
+        ~SparseSet() {
+            free_pages();
+        }
+
+        bool contains(key_type key) const noexcept {
+            const key_type* page = page_for(key);
+            return page && page[OffsetOf(key)] != Tombstone;
+        }
+
+        /**
+         * @brief Dense index of the key, or Tombstone if it is not in the set.
+         */
+        key_type index_of(key_type key) const noexcept {
+            const key_type* page = page_for(key);
+            return page ? page[OffsetOf(key)] : Tombstone;
+        }
+
+        T* get(key_type key) noexcept {
+            const key_type i = index_of(key);
+            return i != Tombstone ? &m_values[i] : nullptr;
+        }
+
+        const T* get(key_type key) const noexcept {
+            const key_type i = index_of(key);
+            return i != Tombstone ? &m_values[i] : nullptr;
+        }
+
+        /**
+         * @brief Inserts a value for key, or replaces the existing one.
+         * @return A pointer to the value, valid until the next insertion or erasure. nullptr if memory could not be allocated or key is the Tombstone.
+         */
+        template<typename... Args>
+        T* emplace(key_type key, Args&&... args) noexcept {
+            if (key == Tombstone) return nullptr;
+            key_type* page = assure_page(key);
+            if (!page) return nullptr;
+            key_type& slot = page[OffsetOf(key)];
+            if (slot != Tombstone) {
+                m_values[slot] = T(std::forward<Args>(args)...);
+                return &m_values[slot];
+            }
+            if (m_values.emplace_back(std::forward<Args>(args)...) != List<T>::Result::Success)
+                return nullptr;
+            if (m_keys.push_back(key) != List<key_type>::Result::Success) {
+                m_values.pop_back();
+                return nullptr;
+            }
+            slot = static_cast<key_type>(m_keys.size() - 1);
+            return &m_values.back();
+        }
+
+        T* insert(key_type key, const T& value) noexcept { return emplace(key, value); }
+        T* insert(key_type key, T&& value) noexcept { return emplace(key, std::move(value)); }
+
+        /**
+         * @brief Removes the key, the last dense element is moved into its place.
+         */
+        Result erase(key_type key) noexcept {
+            key_type* page = page_for(key);
+            if (!page || page[OffsetOf(key)] == Tombstone) return Result::InvalidArgument;
+            const key_type index = page[OffsetOf(key)];
+            const key_type last = static_cast<key_type>(m_keys.size() - 1);
+            if (index != last) {
+                const key_type movedKey = m_keys[last];
+                m_values[index] = std::move(m_values[last]);
+                m_keys[index] = movedKey;
+                page_for(movedKey)[OffsetOf(movedKey)] = index;
+            }
+            m_values.pop_back();
+            m_keys.pop_back();
+            page[OffsetOf(key)] = Tombstone;
+            return Result::Success;
+        }
+
+        /**
+         * @brief Removes every element, sparse pages are kept.
+         */
+        void clear() noexcept {
+            for (size_type i = 0; i < m_keys.size(); ++i) {
+                const key_type key = m_keys[i];
+                page_for(key)[OffsetOf(key)] = Tombstone;
+            }
+            m_keys.clear();
+            m_values.clear();
+        }
+
+        Result reserve(size_type count) noexcept {
+            if (m_keys.reserve(count) != List<key_type>::Result::Success || m_values.reserve(count) != List<T>::Result::Success)
+                return Result::OutOfMemory;
+            return Result::Success;
+        }
+
+        size_type size() const noexcept { return m_keys.size(); }
+        bool empty() const noexcept { return m_keys.empty(); }
+
+        /**
+         * @brief The packed keys, in the same order as the values.
+         */
+        const key_type* keys() const noexcept { return m_keys.data(); }
+        T* dense() noexcept { return m_values.data(); }
+        const T* dense() const noexcept { return m_values.data(); }
+
+        iterator begin() noexcept { return m_values.begin(); }
+        iterator end() noexcept { return m_values.end(); }
+        const_iterator begin() const noexcept { return m_values.begin(); }
+        const_iterator end() const noexcept { return m_values.end(); }
+
+        /**
+         * @brief Calls func(key, value) for every element.
+         */
+        template<typename F>
+        void for_each(F&& func) {
+            for (size_type i = 0; i < m_keys.size(); ++i) func(m_keys[i], m_values[i]);
+        }
+
+        template<typename F>
+        void for_each(F&& func) const {
+            for (size_type i = 0; i < m_keys.size(); ++i) func(m_keys[i], m_values[i]);
+        }
+    };
+}
@@ -0,0 +1,320 @@
+#include "pch.h"
+#include "Core/CpuTopology.h"
+#include <bit>
+#ifdef HBR_WINDOWS
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace Hubris;
+
+namespace {
+    //Dense re-indexing of arbitrary OS ids (core ids, cache keys...).
+    uint32_t DenseIndex(std::map<uint64_t, uint32_t>& ids, uint64_t key) {
+        return ids.try_emplace(key, static_cast<uint32_t>(ids.size())).first->second;
+    }
+
+#ifndef HBR_WINDOWS
+    bool ReadFile(const std::string& path, std::string& out) {
+        std::ifstream file(path);
+        if (!file) return false;
+        std::getline(file, out);
+        return true;
+    }
+
+    bool ReadNumber(const std::string& path, uint32_t& out) {
+        std::string text;
+        if (!ReadFile(path, text) || text.empty()) return false;
+        out = static_cast<uint32_t>(std::strtoul(text.c_str(), nullptr, 10));
+        return true;
+    }
+
+    //Parses the kernel's cpu list format: "0-3,8,10-11".
+    std::vector<uint32_t> ParseCpuList(const std::string& text) {
+        std::vector<uint32_t> cpus;
+        size_t pos = 0;
+        while (pos < text.size()) {
+            size_t end = text.find(',', pos);
+            if (end == std::string::npos) end = text.size();
+            const std::string item = text.substr(pos, end - pos);
+            const size_t dash = item.find('-');
+            if (!item.empty() && item[0] >= '0' && item[0] <= '9') {
+                const uint32_t first = static_cast<uint32_t>(std::strtoul(item.c_str(), nullptr, 10));
+                const uint32_t last = dash == std::string::npos ? first : static_cast<uint32_t>(std::strtoul(item.c_str() + dash + 1, nullptr, 10));
+                for (uint32_t c = first; c <= last; ++c) cpus.push_back(c);
+            }
+            pos = end + 1;
+        }
+        return cpus;
+    }
+
+    bool DetectLinux(std::vector<LogicalCpu>& cpus) {
+        const std::string root = "/sys/devices/system/cpu/";
+        std::string online;
+        if (!ReadFile(root + "online", online)) return false;
+        const std::vector<uint32_t> ids = ParseCpuList(online);
+        if (ids.empty()) return false;
+
+        std::map<uint64_t, uint32_t> cores, caches, packages;
+        for (uint32_t id : ids) {
+            const std::string dir = root + "cpu" + std::to_string(id) + "/";
+            LogicalCpu cpu;
+            cpu.Id = id;
+
+            uint32_t package = 0, core = id;
+            ReadNumber(dir + "topology/physical_package_id", package);
+            ReadNumber(dir + "topology/core_id", core);
+            cpu.Package = DenseIndex(packages, package);
+            cpu.Core = DenseIndex(cores, (uint64_t(package) << 32) | core);
+
+            std::string siblings;
+            if (ReadFile(dir + "topology/thread_siblings_list", siblings)) {
+                const std::vector<uint32_t> list = ParseCpuList(siblings);
+                cpu.Sibling = static_cast<uint32_t>(std::find(list.begin(), list.end(), id) - list.begin());
+                if (cpu.Sibling >= list.size()) cpu.Sibling = 0;
+            }
+
+            //The highest cache level is the last level cache, keyed by the first cpu sharing it.
+            uint32_t bestLevel = 0;
+            uint64_t cacheKey = uint64_t(1) << 63 | cpu.Package;
+            for (uint32_t index = 0;; ++index) {
+                const std::string cacheDir = dir + "cache/index" + std::to_string(index) + "/";
+                uint32_t level = 0;
+                if (!ReadNumber(cacheDir + "level", level)) break;
+                std::string shared;
+                if (level > bestLevel && ReadFile(cacheDir + "shared_cpu_list", shared)) {
+                    const std::vector<uint32_t> list = ParseCpuList(shared);
+                    if (!list.empty()) {
+                        bestLevel = level;
+                        cacheKey = list.front();
+                    }
+                }
+            }
+            cpu.Cache = DenseIndex(caches, cacheKey);
+            cpus.push_back(cpu);
+        }
+
+        //NUMA nodes list their cpus, the same information libnuma reads.
+        std::string nodesOnline;
+        if (ReadFile("/sys/devices/system/node/online", nodesOnline)) {
+            for (uint32_t node : ParseCpuList(nodesOnline)) {
+                std::string list;
+                if (!ReadFile("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist", list)) continue;
+                for (uint32_t id : ParseCpuList(list)) {
+                    for (LogicalCpu& cpu : cpus) {
+                        if (cpu.Id == id) cpu.Node = node;
+                    }
+                }
+            }
+        }
+        return true;
+    }
+#else
+    //Calls fn(id) for every logical processor of a group affinity mask.
+    template<typename F>
+    void ForEachInMask(const GROUP_AFFINITY& mask, F&& fn) {
+        for (KAFFINITY bits = mask.Mask; bits; bits &= bits - 1)
+            fn(static_cast<uint32_t>(mask.Group) * 64 + static_cast<uint32_t>(std::countr_zero(static_cast<uint64_t>(bits))));
+    }
+
+    bool DetectWindows(std::vector<LogicalCpu>& cpus) {
+        DWORD length = 0;
+        GetLogicalProcessorInformationEx(RelationAll, nullptr, &length);
+        if (GetLastError() != ERROR_INSUFFICIENT_BUFFER) return false;
+        std::vector<unsigned char> buffer(length);
+        auto* base = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data());
+        if (!GetLogicalProcessorInformationEx(RelationAll, base, &length)) return false;
+
+        std::map<uint32_t, size_t> byId;
+        const auto find = [&](uint32_t id) -> LogicalCpu* {
+            auto it = byId.find(id);
+            return it == byId.end() ? nullptr : &cpus[it->second];
+        };
+
+        //Cores first, they define the logical processors.
+        uint32_t coreIndex = 0;
+        for (DWORD offset = 0; offset < length;) {
+            auto* info = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+            if (info->Relationship == RelationProcessorCore) {
+                uint32_t sibling = 0;
+                for (WORD g = 0; g < info->Processor.GroupCount; ++g) {
+                    ForEachInMask(info->Processor.GroupMask[g], [&](uint32_t id) {
+                        byId[id] = cpus.size();
+                        cpus.push_back(LogicalCpu{ id, coreIndex, sibling++, 0, 0, 0 });
+                    });
+                }
+                ++coreIndex;
+            }
+            offset += info->Size;
+        }
+
+        uint32_t packageIndex = 0, cacheIndex = 0;
+        for (DWORD offset = 0; offset < length;) {
+            auto* info = reinterpret_cast<SYSTEM_LOGICAL_PROCESSOR_INFORMATION_EX*>(buffer.data() + offset);
+            switch (info->Relationship) {
+            case RelationProcessorPackage:
+                for (WORD g = 0; g < info->Processor.GroupCount; ++g)
+                    ForEachInMask(info->Processor.GroupMask[g], [&](uint32_t id) { if (LogicalCpu* c = find(id)) c->Package = packageIndex; });
+                ++packageIndex;
+                break;
+            case RelationCache:
+                if (info->Cache.Level == 3) {
+                    ForEachInMask(info->Cache.GroupMask, [&](uint32_t id) { if (LogicalCpu* c = find(id)) c->Cache = cacheIndex; });
+                    ++cacheIndex;
+                }
+                break;
+            case RelationNumaNode:
+                ForEachInMask(info->NumaNode.GroupMask, [&](uint32_t id) { if (LogicalCpu* c = find(id)) c->Node = info->NumaNode.NodeNumber; });
+                break;
+            default:
+                break;
+            }
+            offset += info->Size;
+        }
+        //No L3 reported: one domain per package.
+        if (cacheIndex == 0) {
+            for (LogicalCpu& c : cpus) c.Cache = c.Package;
+        }
+        return !cpus.empty();
+    }
+#endif
+
+    /**
+     * @brief Drops the CPUs the process may not run on (taskset, container cpuset, job objects), then re-densifies the indices.
+     * Leaves the list untouched if the mask cannot be read or excludes everything.
+     */
+    void RestrictToAffinity(std::vector<LogicalCpu>& cpus) {
+        std::vector<LogicalCpu> allowed;
+#ifdef HBR_WINDOWS
+        DWORD_PTR process = 0, system = 0;
+        USHORT groups[4] = {};
+        USHORT groupCount = 4;
+        //The mask only describes the process' group, and is 0 when the process spans several.
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &process, &system) || process == 0) return;
+        if (!GetProcessGroupAffinity(GetCurrentProcess(), &groupCount, groups) || groupCount != 1) return;
+        for (const LogicalCpu& cpu : cpus) {
+            if (cpu.Id / 64 == groups[0] && (process >> (cpu.Id % 64)) & 1) allowed.push_back(cpu);
+        }
+#elif defined(HBR_LINUX) && !defined(HBR_ANDROID)
+        uint32_t maxId = 0;
+        for (const LogicalCpu& cpu : cpus) maxId = std::max(maxId, cpu.Id);
+        const size_t count = std::max<size_t>(maxId + 1, CPU_SETSIZE);
+        cpu_set_t* set = CPU_ALLOC(count);
+        if (!set) return;
+        const size_t size = CPU_ALLOC_SIZE(count);
+        CPU_ZERO_S(size, set);
+        if (sched_getaffinity(0, size, set) == 0) {
+            for (const LogicalCpu& cpu : cpus) {
+                if (CPU_ISSET_S(cpu.Id, size, set)) allowed.push_back(cpu);
+            }
+        }
+        CPU_FREE(set);
+#else
+        return;
+#endif
+        if (allowed.empty() || allowed.size() == cpus.size()) return;
+
+        std::map<uint64_t, uint32_t> cores, caches, packages;
+        std::map<uint32_t, uint32_t> siblings;      // Allowed threads seen so far, per dense core.
+        //Sibling order inside a core is kept, the first allowed thread becomes sibling 0.
+        std::stable_sort(allowed.begin(), allowed.end(), [](const LogicalCpu& a, const LogicalCpu& b) { return a.Sibling < b.Sibling; });
+        for (LogicalCpu& cpu : allowed) {
+            cpu.Core = DenseIndex(cores, cpu.Core);
+            cpu.Cache = DenseIndex(caches, cpu.Cache);
+            cpu.Package = DenseIndex(packages, cpu.Package);
+            cpu.Sibling = siblings[cpu.Core]++;
+        }
+        std::stable_sort(allowed.begin(), allowed.end(), [](const LogicalCpu& a, const LogicalCpu& b) { return a.Id < b.Id; });
+        cpus = std::move(allowed);
+    }
+}
+
+void CpuTopology::Finalize()
+{
+    const auto countOf = [this](uint32_t LogicalCpu::* field) {
+        uint32_t count = 0;
+        for (const LogicalCpu& cpu : m_cpus) count = std::max(count, cpu.*field + 1);
+        return count;
+    };
+    m_coreCount = countOf(&LogicalCpu::Core);
+    m_cacheCount = countOf(&LogicalCpu::Cache);
+    m_nodeCount = countOf(&LogicalCpu::Node);
+    m_packageCount = countOf(&LogicalCpu::Package);
+}
+
+CpuTopology CpuTopology::Detect()
+{
+    CpuTopology topology;
+#ifdef HBR_WINDOWS
+    topology.m_detected = DetectWindows(topology.m_cpus);
+#else
+    topology.m_detected = DetectLinux(topology.m_cpus);
+#endif
+    if (!topology.m_detected) {
+        topology.m_cpus.clear();
+        const uint32_t count = std::max(std::thread::hardware_concurrency(), 1u);
+        for (uint32_t i = 0; i < count; ++i) topology.m_cpus.push_back(LogicalCpu{ i, i, 0, 0, 0, 0 });
+    }
+    RestrictToAffinity(topology.m_cpus);
+    topology.Finalize();
+    return topology;
+}
+
+const CpuTopology& CpuTopology::Get()
+{
+    static const CpuTopology topology = [] {
+        CpuTopology t = Detect();
+        Logger::Log("CPU topology: {} logical, {} cores, {} L3 domains, {} NUMA nodes, {} packages{}",
+            t.GetLogicalCount(), t.GetCoreCount(), t.GetCacheCount(), t.GetNodeCount(), t.GetPackageCount(), t.IsDetected() ? "" : " (fallback)");
+        return t;
+    }();
+    return topology;
+}
+
+bool CpuTopology::PinCurrentThread(uint32_t cpu) const
+{
+    if (cpu >= m_cpus.size() || !m_detected) return false;
+    const uint32_t id = m_cpus[cpu].Id;
+#ifdef HBR_WINDOWS
+    GROUP_AFFINITY affinity = {};
+    affinity.Group = static_cast<WORD>(id / 64);
+    affinity.Mask = KAFFINITY(1) << (id % 64);
+    return SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr) != 0;
+#elif defined(HBR_LINUX) && !defined(HBR_ANDROID)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(id, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
+
+CpuTopology::Distance CpuTopology::GetDistance(uint32_t a, uint32_t b) const noexcept
+{
+    const LogicalCpu& x = m_cpus[a];
+    const LogicalCpu& y = m_cpus[b];
+    if (a == b) return Distance::Same;
+    if (x.Core == y.Core) return Distance::SmtSibling;
+    if (x.Cache == y.Cache) return Distance::SharedCache;
+    if (x.Node == y.Node) return Distance::SameNode;
+    if (x.Package == y.Package) return Distance::SamePackage;
+    return Distance::Remote;
+}
+
+std::vector<uint32_t> CpuTopology::GetSpreadOrder() const
+{
+    std::vector<uint32_t> order(m_cpus.size());
+    for (uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) {
+        const LogicalCpu& x = m_cpus[a];
+        const LogicalCpu& y = m_cpus[b];
+        if (x.Sibling != y.Sibling) return x.Sibling < y.Sibling;
+        if (x.Node != y.Node) return x.Node < y.Node;
+        if (x.Cache != y.Cache) return x.Cache < y.Cache;
+        return x.Core < y.Core;
+    });
+    return order;
+}
@@ -0,0 +1,122 @@
+#include "pch.h"
+#include "Core/EventBus.h"
+
+using namespace Hubris;
+using namespace Hubris::Core;
+
+namespace {
+    template<typename Types>
+    auto FindType(Types& types, uint64_t type) {
+        return std::lower_bound(types.begin(), types.end(), type, [](const auto& handlers, uint64_t t) { return handlers.Type < t; });
+    }
+
+    struct ByChannel {
+        bool operator()(const auto& entry, uint64_t channel) const noexcept { return entry.Channel < channel; }
+        bool operator()(uint64_t channel, const auto& entry) const noexcept { return channel < entry.Channel; }
+    };
+
+    template<typename Entries>
+    auto ChannelRange(Entries& entries, uint64_t channel) {
+        return std::equal_range(entries.begin(), entries.end(), channel, ByChannel{});
+    }
+}
+
+EventBus::~EventBus()
+{
+    delete m_table.load(std::memory_order_relaxed);
+    //The tables replaced while being read, nothing reads them anymore.
+    Rcu::Reclaim();
+}
+
+Subscription EventBus::Add(uint64_t type, StringId channel, int32_t priority, ErasedHandler handler)
+{
+    Subscription subscription;
+    {
+        std::lock_guard<SpinLock> guard(m_lock);
+        subscription = m_subscriptions.Acquire();
+        if (!subscription.IsValid()) return subscription;
+
+        const Table* old = m_table.load(std::memory_order_relaxed);
+        auto table = old ? std::make_unique<Table>(*old) : std::make_unique<Table>();
+        if (m_tombstones > 0) {
+            for (TypeHandlers& handlers : table->Types)
+                std::erase_if(handlers.Entries, [&](const Entry& e) { return !m_subscriptions.IsLive(e.Slot, e.Generation); });
+            std::erase_if(table->Types, [](const TypeHandlers& handlers) { return handlers.Entries.empty(); });
+            m_tombstones = 0;
+        }
+
+        auto it = FindType(table->Types, type);
+        if (it == table->Types.end() || it->Type != type) it = table->Types.insert(it, TypeHandlers{ type, {} });
+        const Entry entry{ channel.Value(), priority, m_order++, handler, subscription.Slot, subscription.Generation };
+        //After every entry of the same channel and priority: equal priorities keep the subscription order.
+        const auto at = std::upper_bound(it->Entries.begin(), it->Entries.end(), entry, [](const Entry& a, const Entry& b) {
+            return a.Channel != b.Channel ? a.Channel < b.Channel : a.Priority > b.Priority;
+        });
+        it->Entries.insert(at, entry);
+        m_entryCount = 0;
+        for (const TypeHandlers& handlers : table->Types) m_entryCount += handlers.Entries.size();
+
+        m_table.store(table.release(), std::memory_order_seq_cst);
+        if (old) Rcu::Retire(old);
+    }
+    Rcu::Reclaim();
+    return subscription;
+}
+
+bool EventBus::Unsubscribe(Subscription subscription)
+{
+    {
+        std::lock_guard<SpinLock> guard(m_lock);
+        if (!m_subscriptions.Release(subscription)) return false;
+        if (++m_tombstones * 2 <= m_entryCount) return true;
+
+        //Tombstones outnumber the live handlers: compact.
+        const Table* old = m_table.load(std::memory_order_relaxed);
+        auto table = std::make_unique<Table>();
+        m_entryCount = 0;
+        for (const TypeHandlers& handlers : old->Types) {
+            TypeHandlers live{ handlers.Type, {} };
+            for (const Entry& e : handlers.Entries) {
+                if (m_subscriptions.IsLive(e.Slot, e.Generation)) live.Entries.push_back(e);
+            }
+            m_entryCount += live.Entries.size();
+            if (!live.Entries.empty()) table->Types.push_back(std::move(live));
+        }
+        m_tombstones = 0;
+        m_table.store(table.release(), std::memory_order_seq_cst);
+        Rcu::Retire(old);
+    }
+    Rcu::Reclaim();
+    return true;
+}
+
+bool EventBus::Publish(uint64_t type, StringId channel, const void* event) const
+{
+    Rcu::ReadGuard guard;
+    const Table* table = m_table.load(std::memory_order_seq_cst);
+    if (!table) return false;
+    const auto handlers = FindType(table->Types, type);
+    if (handlers == table->Types.end() || handlers->Type != type) return false;
+
+    //Handlers of every channel, merged by priority with those of the event's channel.
+    auto [any, anyEnd] = ChannelRange(handlers->Entries, 0);
+    auto [own, ownEnd] = channel.IsEmpty() ? std::pair(anyEnd, anyEnd) : ChannelRange(handlers->Entries, channel.Value());
+    while (any != anyEnd || own != ownEnd) {
+        const bool takeOwn = any == anyEnd ||
+            (own != ownEnd && (own->Priority != any->Priority ? own->Priority > any->Priority : own->Order < any->Order));
+        const Entry& entry = takeOwn ? *own++ : *any++;
+        if (m_subscriptions.IsLive(entry.Slot, entry.Generation) && entry.Handler(event)) return true;
+    }
+    return false;
+}
+
+size_t EventBus::GetHandlerCount(uint64_t type) const
+{
+    Rcu::ReadGuard guard;
+    const Table* table = m_table.load(std::memory_order_seq_cst);
+    if (!table) return 0;
+    const auto handlers = FindType(table->Types, type);
+    if (handlers == table->Types.end() || handlers->Type != type) return 0;
+    return static_cast<size_t>(std::count_if(handlers->Entries.begin(), handlers->Entries.end(),
+        [&](const Entry& e) { return m_subscriptions.IsLive(e.Slot, e.Generation); }));
+}
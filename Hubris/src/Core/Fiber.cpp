@@ -0,0 +1,133 @@
+#include "pch.h"
+#include "Core/Fiber.h"
+#ifdef HBR_WINDOWS
+#include <Windows.h>
+#else
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace Hubris;
+
+#ifdef HBR_WINDOWS
+
+struct Detail::FiberContext {
+    LPVOID Handle = nullptr;
+    LPVOID Caller = nullptr;
+    Fiber::EntryPoint Entry = nullptr;
+    void* Arg = nullptr;
+};
+
+namespace {
+    VOID CALLBACK FiberProc(LPVOID param) {
+        auto* context = static_cast<Detail::FiberContext*>(param);
+        context->Entry(context->Arg);
+    }
+}
+
+bool Fiber::Create(EntryPoint entry, void* arg, size_t stackSize) noexcept
+{
+    if (m_context) return false;
+    auto* context = new(std::nothrow) Detail::FiberContext{ nullptr, nullptr, entry, arg };
+    if (!context) return false;
+    context->Handle = CreateFiberEx(stackSize, stackSize, FIBER_FLAG_FLOAT_SWITCH, FiberProc, context);
+    if (!context->Handle) {
+        delete context;
+        return false;
+    }
+    m_context = context;
+    return true;
+}
+
+Fiber::~Fiber()
+{
+    if (!m_context) return;
+    DeleteFiber(m_context->Handle);
+    delete m_context;
+}
+
+void Fiber::SwitchTo() noexcept
+{
+    //Threads have to be fibers themselves before they can switch to one.
+    if (!IsThreadAFiber()) ConvertThreadToFiberEx(nullptr, FIBER_FLAG_FLOAT_SWITCH);
+    m_context->Caller = GetCurrentFiber();
+    SwitchToFiber(m_context->Handle);
+}
+
+void Fiber::SwitchBack() noexcept
+{
+    SwitchToFiber(m_context->Caller);
+}
+
+#else
+
+struct Detail::FiberContext {
+    ucontext_t Self;
+    ucontext_t Caller;
+    void* Stack = nullptr;
+    size_t MappedSize = 0;
+    Fiber::EntryPoint Entry = nullptr;
+    void* Arg = nullptr;
+};
+
+namespace {
+    //makecontext only passes int arguments, the context pointer is split in two halves.
+    void FiberProc(unsigned int high, unsigned int low) {
+        const uintptr_t address = (static_cast<uintptr_t>(high) << 32) | low;
+        auto* context = reinterpret_cast<Detail::FiberContext*>(address);
+        context->Entry(context->Arg);
+    }
+}
+
+bool Fiber::Create(EntryPoint entry, void* arg, size_t stackSize) noexcept
+{
+    if (m_context) return false;
+    auto* context = new(std::nothrow) Detail::FiberContext{};
+    if (!context) return false;
+
+    //One extra page at the bottom of the stack is left inaccessible to catch overflows.
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t usable = (stackSize + page - 1) & ~(page - 1);
+    const size_t mapped = usable + page;
+    void* memory = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        delete context;
+        return false;
+    }
+    mprotect(memory, page, PROT_NONE);
+
+    context->Stack = memory;
+    context->MappedSize = mapped;
+    context->Entry = entry;
+    context->Arg = arg;
+    getcontext(&context->Self);
+    context->Self.uc_stack.ss_sp = static_cast<char*>(memory) + page;
+    context->Self.uc_stack.ss_size = usable;
+    context->Self.uc_link = nullptr;
+    const uintptr_t address = reinterpret_cast<uintptr_t>(context);
+    makecontext(&context->Self, reinterpret_cast<void(*)()>(&FiberProc), 2,
+        static_cast<unsigned int>(address >> 32), static_cast<unsigned int>(address & 0xFFFFFFFFu));
+    m_context = context;
+    return true;
+}
+
+Fiber::~Fiber()
+{
+    if (!m_context) return;
+    munmap(m_context->Stack, m_context->MappedSize);
+    delete m_context;
+}
+
+//swapcontext costs a sigprocmask call per switch. _longjmp would not, but jumping onto another stack is rejected by fortified glibc builds.
+void Fiber::SwitchTo() noexcept
+{
+    swapcontext(&m_context->Caller, &m_context->Self);
+}
+
+void Fiber::SwitchBack() noexcept
+{
+    swapcontext(&m_context->Self, &m_context->Caller);
+}
+
+#endif
@@ -0,0 +1,60 @@
+#include "pch.h"
+#include "Core/FramePipeline.h"
+
+using namespace Hubris;
+
+FramePipeline::FramePipeline(RenderFunc render, uint32_t depth) noexcept
+    : m_render(render), m_depth(std::clamp<uint32_t>(depth, 1, MaxDepth))
+{
+}
+
+void FramePipeline::SetDepth(uint32_t depth)
+{
+    Flush();
+    m_depth = std::clamp<uint32_t>(depth, 1, MaxDepth);
+}
+
+uint64_t FramePipeline::BeginFrame()
+{
+    //Renders finish in order: once frame - depth is done, so is every frame sharing our slot.
+    if (m_frame >= m_depth) ThreadPool::Wait(m_inFlight[(m_frame - m_depth) % MaxDepth]);
+    return m_frame;
+}
+
+void FramePipeline::SubmitRender()
+{
+    const uint64_t frame = m_frame++;
+    m_inFlight[frame % MaxDepth].Add(1);
+    //seq_cst, paired with RenderStage clearing the flag then reading m_submitted: either it sees this frame, or we see the stage idle.
+    m_submitted.store(frame + 1, std::memory_order_seq_cst);
+    const bool serial = m_depth == 1 || ThreadPool::GetThreadCount() == 0;
+    if (!m_renderActive.exchange(true, std::memory_order_seq_cst)) {
+        if (serial) RenderStage();
+        else ThreadPool::QueueJob(JobPriority::Critical, nullptr, [this] { RenderStage(); });
+    }
+    //Still active on the pool (the depth was just lowered): it picks the frame up, wait for it.
+    if (serial) ThreadPool::Wait(m_inFlight[frame % MaxDepth]);
+}
+
+void FramePipeline::RenderStage()
+{
+    while (true) {
+        const uint64_t submitted = m_submitted.load(std::memory_order_acquire);
+        while (m_nextRender < submitted) {
+            const uint64_t frame = m_nextRender++;
+            if (m_render) m_render(frame);
+            m_inFlight[frame % MaxDepth].Done();
+        }
+        //m_nextRender belongs to the next owner once the flag is cleared.
+        const uint64_t rendered = m_nextRender;
+        m_renderActive.store(false, std::memory_order_seq_cst);
+        //A frame submitted before the flag was cleared saw the stage active and did not queue it: take it, unless someone else did.
+        if (m_submitted.load(std::memory_order_seq_cst) == rendered) return;
+        if (m_renderActive.exchange(true, std::memory_order_acq_rel)) return;
+    }
+}
+
+void FramePipeline::Flush()
+{
+    for (WaitGroup& frame : m_inFlight) ThreadPool::Wait(frame);
+}
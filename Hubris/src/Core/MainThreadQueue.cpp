@@ -0,0 +1,67 @@
+#include "pch.h"
+#include "Core/MainThreadQueue.h"
+
+using namespace Hubris;
+
+namespace {
+    const std::thread::id MainThread = std::this_thread::get_id();
+
+    MPMCQueue<MainThreadQueue::Item, MainThreadQueue::Capacity> Queue;
+    //Only used when the queue is full.
+    SpinLock OverflowLock;
+    std::vector<MainThreadQueue::Item> Overflow;
+    std::atomic<bool> HasOverflow{ false };
+}
+
+bool MainThreadQueue::IsMainThread() noexcept
+{
+    return std::this_thread::get_id() == MainThread;
+}
+
+void MainThreadQueue::Post(Item item) noexcept
+{
+    //Once spilled, every post goes to the list until it is drained: it must not overtake the spilled calls.
+    if (!HasOverflow.load(std::memory_order_acquire) && Queue.Enqueue(item)) return;
+    std::lock_guard<SpinLock> lock(OverflowLock);
+    Overflow.push_back(item);
+    HasOverflow.store(true, std::memory_order_release);
+}
+
+size_t MainThreadQueue::Drain(Clock::duration budget)
+{
+    const Clock::time_point start = Clock::now();
+    const bool timed = budget != Clock::duration::max();
+    size_t ran = 0;
+    //At least one call per drain, so a single slow call cannot stall the queue forever.
+    const auto expired = [&] { return timed && ran > 0 && Clock::now() - start >= budget; };
+
+    //Only what is queued now: calls posting again while they run wait for the next drain.
+    const size_t pending = Queue.Size();
+    Item item;
+    for (size_t i = 0; i < pending && !expired() && Queue.Dequeue(item); ++i, ++ran) item.Invoke(item.State);
+
+    //Spilled calls are newer than everything in the queue, they run once it is empty.
+    if (!HasOverflow.load(std::memory_order_acquire) || !Queue.IsEmpty() || expired()) return ran;
+    std::vector<Item> overflow;
+    {
+        std::lock_guard<SpinLock> lock(OverflowLock);
+        overflow.swap(Overflow);
+    }
+    size_t i = 0;
+    for (; i < overflow.size() && !expired(); ++i, ++ran) overflow[i].Invoke(overflow[i].State);
+    std::lock_guard<SpinLock> lock(OverflowLock);
+    //Calls spilled meanwhile are newer than the ones left over. The flag stays set until the list is empty.
+    Overflow.insert(Overflow.begin(), overflow.begin() + i, overflow.end());
+    if (Overflow.empty()) HasOverflow.store(false, std::memory_order_release);
+    return ran;
+}
+
+size_t MainThreadQueue::GetPendingCount() noexcept
+{
+    size_t pending = Queue.Size();
+    if (HasOverflow.load(std::memory_order_acquire)) {
+        std::lock_guard<SpinLock> lock(OverflowLock);
+        pending += Overflow.size();
+    }
+    return pending;
+}
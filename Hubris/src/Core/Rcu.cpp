@@ -0,0 +1,102 @@
+#include "pch.h"
+#include "Core/Rcu.h"
+#include "Core/Sync.h"
+
+using namespace Hubris;
+
+namespace {
+    struct alignas(CacheLineSize) Reader {
+        //Epoch read on entry of the outermost guard, 0 when not reading.
+        std::atomic<uint64_t> Active{ 0 };
+        std::atomic<bool> Owned{ true };
+    };
+
+    struct Retired {
+        uint64_t Epoch;
+        void* Object;
+        void(*Destroy)(void*);
+    };
+
+    //Releases the thread's slot when it exits, for the next thread to reuse.
+    struct ReaderClaim {
+        Reader* Claimed = nullptr;
+        uint32_t Depth = 0;
+        ~ReaderClaim() {
+            if (Claimed) Claimed->Owned.store(false, std::memory_order_release);
+        }
+    };
+
+    std::atomic<uint64_t> Epoch{ 1 };
+    SpinLock ReadersLock;
+    std::vector<std::unique_ptr<Reader>> Readers;
+    SpinLock RetiredLock;
+    std::vector<Retired> RetiredObjects;
+    std::atomic<size_t> RetiredCount{ 0 };
+    thread_local ReaderClaim LocalReader;
+
+    Reader& GetLocalReader() {
+        if (LocalReader.Claimed) return *LocalReader.Claimed;
+        std::lock_guard<SpinLock> lock(ReadersLock);
+        for (auto& reader : Readers) {
+            if (!reader->Owned.load(std::memory_order_relaxed) && !reader->Owned.exchange(true, std::memory_order_acquire))
+                return *(LocalReader.Claimed = reader.get());
+        }
+        Readers.push_back(std::make_unique<Reader>());
+        return *(LocalReader.Claimed = Readers.back().get());
+    }
+}
+
+Rcu::ReadGuard::ReadGuard() noexcept
+{
+    if (LocalReader.Depth++ > 0) return;
+    //seq_cst against the writer: either it sees us reading, or we load the pointer it published.
+    GetLocalReader().Active.store(Epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+}
+
+Rcu::ReadGuard::~ReadGuard()
+{
+    if (--LocalReader.Depth > 0) return;
+    LocalReader.Claimed->Active.store(0, std::memory_order_release);
+}
+
+void Rcu::Defer(void* object, void(*destroy)(void*))
+{
+    //Readers that enter after the bump load the replacement, only those announced with an epoch up to this one may hold object.
+    const uint64_t epoch = Epoch.fetch_add(1, std::memory_order_seq_cst);
+    std::lock_guard<SpinLock> lock(RetiredLock);
+    RetiredObjects.push_back({ epoch, object, destroy });
+    RetiredCount.store(RetiredObjects.size(), std::memory_order_relaxed);
+}
+
+void Rcu::Reclaim()
+{
+    if (RetiredCount.load(std::memory_order_relaxed) == 0) return;
+    uint64_t oldest = UINT64_MAX;
+    {
+        std::lock_guard<SpinLock> lock(ReadersLock);
+        for (auto& reader : Readers) {
+            const uint64_t active = reader->Active.load(std::memory_order_seq_cst);
+            if (active != 0) oldest = std::min(oldest, active);
+        }
+    }
+    std::vector<Retired> expired;
+    {
+        std::lock_guard<SpinLock> lock(RetiredLock);
+        const auto kept = std::partition(RetiredObjects.begin(), RetiredObjects.end(), [&](const Retired& r) { return r.Epoch >= oldest; });
+        expired.assign(kept, RetiredObjects.end());
+        RetiredObjects.erase(kept, RetiredObjects.end());
+        RetiredCount.store(RetiredObjects.size(), std::memory_order_relaxed);
+    }
+    //Outside the lock, a destructor may retire something else.
+    for (const Retired& r : expired) r.Destroy(r.Object);
+}
+
+bool Rcu::IsReading() noexcept
+{
+    return LocalReader.Depth > 0;
+}
+
+size_t Rcu::GetRetiredCount()
+{
+    return RetiredCount.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,79 @@
+#include "pch.h"
+#include "Core/StringId.h"
+#include <shared_mutex>
+#include <mutex>
+#include <cstring>
+
+using namespace Hubris;
+
+namespace {
+    /**
+     * @brief Global string intern table. Characters are copied into large blocks that are never freed or moved,
+     * so the views handed out by Lookup() stay valid for the program's lifetime.
+     */
+    struct InternTable {
+        static constexpr size_t BlockSize = 16 * 1024;
+
+        std::shared_mutex mtx;
+        std::unordered_map<StringId, std::string_view> strings;
+        std::vector<std::unique_ptr<char[]>> blocks;
+        size_t blockUsed = BlockSize;
+
+        std::string_view Store(std::string_view str) {
+            if (str.empty()) return std::string_view();
+            if (str.size() > BlockSize / 4) {
+                //Large strings get their own block, inserted before the current block so it keeps being filled.
+                auto pos = blocks.empty() ? blocks.end() : blocks.end() - 1;
+                char* dst = blocks.insert(pos, std::unique_ptr<char[]>(new char[str.size()]))->get();
+                std::memcpy(dst, str.data(), str.size());
+                return std::string_view(dst, str.size());
+            }
+            if (blockUsed + str.size() > BlockSize) {
+                blocks.emplace_back(new char[BlockSize]);
+                blockUsed = 0;
+            }
+            char* dst = blocks.back().get() + blockUsed;
+            std::memcpy(dst, str.data(), str.size());
+            blockUsed += str.size();
+            return std::string_view(dst, str.size());
+        }
+    };
+
+    InternTable& GetTable() {
+        static InternTable table;
+        return table;
+    }
+}
+
+StringId StringId::Intern(std::string_view str)
+{
+    const StringId id = Hash(str);
+    InternTable& table = GetTable();
+    {
+        std::shared_lock lock(table.mtx);
+        auto it = table.strings.find(id);
+        if (it != table.strings.end()) {
+#if defined(_DEBUG) || defined(DEBUG)
+            if (it->second != str) {
+                Logger::Fatal("StringId collision between \"{}\" and \"{}\"", it->second, str);
+            }
+#endif
+            return id;
+        }
+    }
+    std::unique_lock lock(table.mtx);
+    //Another thread may have interned it between the two locks.
+    auto [it, inserted] = table.strings.try_emplace(id);
+    if (inserted) {
+        it->second = table.Store(str);
+    }
+    return id;
+}
+
+std::string_view StringId::Lookup(StringId id)
+{
+    InternTable& table = GetTable();
+    std::shared_lock lock(table.mtx);
+    auto it = table.strings.find(id);
+    return it != table.strings.end() ? it->second : std::string_view();
+}
@@ -0,0 +1,86 @@
+#include "pch.h"
+#include "Core/Task.h"
+#include "Core/MainThreadQueue.h"
+#include <new>
+
+using namespace Hubris;
+
+namespace {
+    constexpr size_t MinFrameShift = 6;             // 64 bytes
+    constexpr size_t FrameClassCount = 7;           // 64 .. 4096 bytes, larger frames go to the global heap.
+    constexpr size_t MaxCachedFrames = 256;         // Per class and per thread.
+
+    struct FrameNode {
+        FrameNode* Next;
+    };
+
+    /**
+     * @brief Per-thread free lists of coroutine frames. Frames often finish on another thread than the one that created them,
+     * they simply join the free list of the thread that frees them.
+     */
+    struct FrameCache {
+        FrameNode* Heads[FrameClassCount] = {};
+        size_t Counts[FrameClassCount] = {};
+
+        ~FrameCache() {
+            for (size_t c = 0; c < FrameClassCount; ++c) {
+                while (Heads[c]) {
+                    FrameNode* next = Heads[c]->Next;
+                    ::operator delete(Heads[c]);
+                    Heads[c] = next;
+                }
+            }
+        }
+    };
+
+    thread_local FrameCache LocalFrames;
+
+    constexpr size_t ClassOf(size_t size) noexcept {
+        size_t c = 0;
+        while ((size_t(1) << (MinFrameShift + c)) < size) ++c;
+        return c;
+    }
+}
+
+void* Detail::AllocateFrame(size_t size)
+{
+    const size_t c = ClassOf(size);
+    if (c >= FrameClassCount) return ::operator new(size);
+    if (FrameNode* frame = LocalFrames.Heads[c]) {
+        LocalFrames.Heads[c] = frame->Next;
+        --LocalFrames.Counts[c];
+        return frame;
+    }
+    return ::operator new(size_t(1) << (MinFrameShift + c));
+}
+
+void Detail::FreeFrame(void* frame, size_t size) noexcept
+{
+    const size_t c = ClassOf(size);
+    if (c >= FrameClassCount || LocalFrames.Counts[c] >= MaxCachedFrames) {
+        ::operator delete(frame);
+        return;
+    }
+    auto* node = static_cast<FrameNode*>(frame);
+    node->Next = LocalFrames.Heads[c];
+    LocalFrames.Heads[c] = node;
+    ++LocalFrames.Counts[c];
+}
+
+void Detail::PostToMainThread(std::coroutine_handle<> handle) noexcept
+{
+    //The frame address is the state, no allocation.
+    MainThreadQueue::Post(MainThreadQueue::Item{ [](void* frame) {
+        std::coroutine_handle<>::from_address(frame).resume();
+    }, handle.address() });
+}
+
+bool MainThreadAwaiter::await_ready() const noexcept
+{
+    return MainThreadQueue::IsMainThread();
+}
+
+size_t Hubris::ResumeMainThreadTasks()
+{
+    return MainThreadQueue::Drain();
+}
@@ -0,0 +1,210 @@
+#include "pch.h"
+#include "Core/TaskGraph.h"
+
+using namespace Hubris;
+
+TaskGraph::NodeId TaskGraph::AddNode(StringId name, std::function<void()> work,
+    std::initializer_list<StringId> reads, std::initializer_list<StringId> writes, uint32_t cost)
+{
+    Node node;
+    node.Name = name;
+    node.Work = std::move(work);
+    node.Cost = cost;
+    node.Reads.assign(reads.begin(), reads.end());
+    node.Writes.assign(writes.begin(), writes.end());
+    m_nodes.push_back(std::move(node));
+    m_compiled = false;
+    return static_cast<NodeId>(m_nodes.size() - 1);
+}
+
+TaskGraph::Result TaskGraph::AddEdge(NodeId before, NodeId after)
+{
+    if (before >= m_nodes.size() || after >= m_nodes.size() || before == after) return Result::InvalidArgument;
+    m_explicitEdges.emplace_back(before, after);
+    m_compiled = false;
+    return Result::Success;
+}
+
+TaskGraph::Result TaskGraph::Reads(NodeId node, StringId resource)
+{
+    if (node >= m_nodes.size()) return Result::InvalidArgument;
+    m_nodes[node].Reads.push_back(resource);
+    m_compiled = false;
+    return Result::Success;
+}
+
+TaskGraph::Result TaskGraph::Writes(NodeId node, StringId resource)
+{
+    if (node >= m_nodes.size()) return Result::InvalidArgument;
+    m_nodes[node].Writes.push_back(resource);
+    m_compiled = false;
+    return Result::Success;
+}
+
+TaskGraph::Result TaskGraph::Compile()
+{
+    const NodeId count = static_cast<NodeId>(m_nodes.size());
+    std::vector<std::pair<NodeId, NodeId>> edges = m_explicitEdges;
+
+    //Resource hazards, in registration order.
+    struct ResourceState {
+        NodeId LastWriter = InvalidNode;
+        std::vector<NodeId> Readers;    // Since the last write.
+    };
+    std::unordered_map<StringId, ResourceState> resources;
+    for (NodeId n = 0; n < count; ++n) {
+        for (StringId r : m_nodes[n].Reads) {
+            ResourceState& state = resources[r];
+            if (state.LastWriter != InvalidNode && state.LastWriter != n) edges.emplace_back(state.LastWriter, n);
+            state.Readers.push_back(n);
+        }
+        for (StringId w : m_nodes[n].Writes) {
+            ResourceState& state = resources[w];
+            if (state.LastWriter != InvalidNode && state.LastWriter != n) edges.emplace_back(state.LastWriter, n);
+            for (NodeId reader : state.Readers) {
+                if (reader != n) edges.emplace_back(reader, n);
+            }
+            state.LastWriter = n;
+            state.Readers.clear();
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    //Successor lists, compressed.
+    m_successorOffsets.assign(count + 1, 0);
+    m_predecessorCounts.assign(count, 0);
+    for (const auto& [from, to] : edges) {
+        ++m_successorOffsets[from + 1];
+        ++m_predecessorCounts[to];
+    }
+    for (NodeId n = 0; n < count; ++n) m_successorOffsets[n + 1] += m_successorOffsets[n];
+    m_successors.resize(edges.size());
+    //edges is sorted by source, successors fill in order.
+    for (size_t e = 0; e < edges.size(); ++e) m_successors[e] = edges[e].second;
+
+    //Kahn's algorithm.
+    m_order.clear();
+    m_order.reserve(count);
+    std::vector<uint32_t> remaining = m_predecessorCounts;
+    for (NodeId n = 0; n < count; ++n) {
+        if (remaining[n] == 0) m_order.push_back(n);
+    }
+    for (size_t i = 0; i < m_order.size(); ++i) {
+        const NodeId n = m_order[i];
+        for (uint32_t s = m_successorOffsets[n]; s < m_successorOffsets[n + 1]; ++s) {
+            if (--remaining[m_successors[s]] == 0) m_order.push_back(m_successors[s]);
+        }
+    }
+    if (m_order.size() != count) {
+        m_order.clear();
+        m_compiled = false;
+        Logger::Log("TaskGraph: the dependencies form a cycle.");
+        return Result::Cycle;
+    }
+
+    //Critical path ranks, from the sinks up.
+    m_ranks.assign(count, 0);
+    for (size_t i = count; i-- > 0;) {
+        const NodeId n = m_order[i];
+        uint64_t longest = 0;
+        for (uint32_t s = m_successorOffsets[n]; s < m_successorOffsets[n + 1]; ++s)
+            longest = std::max(longest, m_ranks[m_successors[s]]);
+        m_ranks[n] = m_nodes[n].Cost + longest;
+    }
+    const auto byRank = [this](NodeId a, NodeId b) { return m_ranks[a] > m_ranks[b]; };
+    for (NodeId n = 0; n < count; ++n)
+        std::sort(m_successors.begin() + m_successorOffsets[n], m_successors.begin() + m_successorOffsets[n + 1], byRank);
+    m_roots.clear();
+    for (NodeId n = 0; n < count; ++n) {
+        if (m_predecessorCounts[n] == 0) m_roots.push_back(n);
+    }
+    std::sort(m_roots.begin(), m_roots.end(), byRank);
+
+    m_pending.reset(new std::atomic<uint32_t>[count]);
+    m_compiled = true;
+    return Result::Success;
+}
+
+void TaskGraph::QueueNode(NodeId node)
+{
+    //Frame work: ahead of any Normal or Background job.
+    ThreadPool::QueueJob(JobPriority::Critical, nullptr, [this, node] { RunNode(node); });
+}
+
+void TaskGraph::RunNode(NodeId node)
+{
+    while (true) {
+        m_nodes[node].Work();
+
+        //Successors are sorted by rank: keep the highest ready one for ourselves, queue the others so the highest ranks are picked up first.
+        NodeId next = InvalidNode;
+        const uint32_t first = m_successorOffsets[node];
+        const uint32_t last = m_successorOffsets[node + 1];
+        if (ThreadPool::GetWorkerIndex() >= 0) {
+            //Our deque pops newest first: queue in ascending rank, the highest ready one is the last seen.
+            for (uint32_t s = last; s-- > first;) {
+                const NodeId successor = m_successors[s];
+                if (m_pending[successor].fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+                if (next != InvalidNode) QueueNode(next);
+                next = successor;
+            }
+        }
+        else {
+            //The injection queue is FIFO: descending rank.
+            for (uint32_t s = first; s < last; ++s) {
+                const NodeId successor = m_successors[s];
+                if (m_pending[successor].fetch_sub(1, std::memory_order_acq_rel) != 1) continue;
+                if (next == InvalidNode) next = successor;
+                else QueueNode(successor);
+            }
+        }
+        //The graph may be released by Execute once the last node signaled, nothing is touched after that.
+        m_group.Done();
+        if (next == InvalidNode) return;
+        node = next;
+    }
+}
+
+TaskGraph::Result TaskGraph::Execute()
+{
+    if (!m_compiled) {
+        const Result result = Compile();
+        if (result != Result::Success) return result;
+    }
+    const NodeId count = static_cast<NodeId>(m_nodes.size());
+    if (count == 0) return Result::Success;
+
+    for (NodeId n = 0; n < count; ++n) m_pending[n].store(m_predecessorCounts[n], std::memory_order_relaxed);
+    m_group.Add(static_cast<int>(count));
+    //Highest rank picked up first: from outside the pool, in rank order (the injection queue is FIFO),
+    //from a worker in reverse (its own deque pops the newest job first).
+    if (ThreadPool::GetWorkerIndex() >= 0) {
+        for (auto root = m_roots.rbegin(); root != m_roots.rend(); ++root) QueueNode(*root);
+    }
+    else {
+        for (NodeId root : m_roots) QueueNode(root);
+    }
+    ThreadPool::Wait(m_group);
+    return Result::Success;
+}
+
+void TaskGraph::Clear()
+{
+    m_nodes.clear();
+    m_explicitEdges.clear();
+    m_successorOffsets.clear();
+    m_successors.clear();
+    m_predecessorCounts.clear();
+    m_ranks.clear();
+    m_roots.clear();
+    m_order.clear();
+    m_pending.reset();
+    m_compiled = false;
+}
+
+uint64_t TaskGraph::GetCriticalPathCost() const noexcept
+{
+    if (!m_compiled || m_roots.empty()) return 0;
+    return m_ranks[m_roots.front()];
+}
@@ -0,0 +1,795 @@
+#include "pch.h"
+#include "Core/ThreadPool.h"
+#include "Core/WorkStealingDeque.h"
+#include "Core/Fiber.h"
+#include "Core/CpuTopology.h"
+#include "Core/TimerWheel.h"
+#include "Core/WorkerLocal.h"
+#include "Core/Rcu.h"
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#define HBR_NOINLINE __declspec(noinline)
+#else
+#define HBR_NOINLINE __attribute__((noinline))
+#endif
+
+using namespace Hubris;
+
+namespace Hubris {
+    /**
+     * @brief A pooled fiber running Job::Kind::Fiber jobs, it loops over the jobs it is handed and never returns.
+     */
+    struct JobFiber {
+        struct ResumeWaiter : WaitGroup::Waiter {
+            JobFiber* Owner = nullptr;
+        };
+
+        Fiber Context;
+        Job* Task = nullptr;                // Job to run when switched to, nullptr once it finished.
+        WaitGroup* WaitingOn = nullptr;     // Set by Wait before suspending, consumed by RunFiber.
+        ResumeWaiter Waiter;
+        Job Resume;                         // Queued by the waiter to continue the fiber on any worker.
+    };
+}
+
+namespace {
+    constexpr size_t DequeCapacity = 4096;
+    constexpr size_t InjectionCapacity = 4096;
+    constexpr size_t JobPoolSize = 4096;        // Job slots per submitting thread, power of two.
+    constexpr size_t JobPoolProbes = 64;        // Slots checked before giving up and running inline.
+    constexpr unsigned int SpinCount = 128;     // Empty polls before a worker parks.
+    constexpr size_t MaxFibers = 128;           // Upper bound of fiber jobs in flight (running or suspended).
+    constexpr size_t IOCapacity = 1024;
+    constexpr size_t LaneCount = 3;             // Critical, Normal and Background, IO jobs have their own threads.
+    constexpr size_t BackgroundLane = static_cast<size_t>(JobPriority::Background);
+
+    /**
+     * @brief Time spent in a state. The ongoing stretch is included when read, a parked worker reports its idle time before it wakes up.
+     * Single writer.
+     */
+    struct StatTimer {
+        std::atomic<uint64_t> Total{ 0 };
+        std::atomic<uint64_t> Since{ 0 };   // Start of the ongoing stretch, 0 if none.
+
+        void Begin(uint64_t now) noexcept {
+            Since.store(now, std::memory_order_relaxed);
+        }
+
+        void End(uint64_t now) noexcept {
+            const uint64_t since = Since.load(std::memory_order_relaxed);
+            if (!since) return;
+            //Cleared first: a reader that sees the new total also sees the stretch is over, and does not count it twice.
+            Since.store(0, std::memory_order_relaxed);
+            Total.store(Total.load(std::memory_order_relaxed) + (now - since), std::memory_order_release);
+        }
+
+        uint64_t Read(uint64_t now) const noexcept {
+            while (true) {
+                const uint64_t since = Since.load(std::memory_order_acquire);
+                const uint64_t total = Total.load(std::memory_order_acquire);
+                if (Since.load(std::memory_order_acquire) != since) continue;
+                return total + (since && now > since ? now - since : 0);
+            }
+        }
+    };
+
+    /**
+     * @brief Live counters behind WorkerStats. A worker's counters have a single writer, ExternalStats is shared by every other thread.
+     */
+    struct alignas(CacheLineSize) StatCounters {
+        std::atomic<uint64_t> JobsRun{ 0 };
+        std::atomic<uint64_t> StealAttempts{ 0 };
+        std::atomic<uint64_t> Steals{ 0 };
+        StatTimer Idle;
+        StatTimer Parked;
+        std::atomic<uint64_t> Latency[WorkerStats::LatencyBuckets] = {};
+    };
+
+    struct alignas(CacheLineSize) Worker {
+        WorkStealingDeque<Job, DequeCapacity> Deques[LaneCount];
+        StatCounters Stats;
+        int Cpu = -1;                       // Logical CPU the worker is pinned to, -1 if not pinned.
+        std::vector<uint32_t> Victims;      // Other workers, closest first.
+        std::vector<uint32_t> TierEnds;     // Victims[TierEnds[t - 1] .. TierEnds[t]) are equally close.
+    };
+
+    /**
+     * @brief Per-thread ring of job slots. A slot is reused once the job it held has completed (InUse cleared by the executing thread).
+     */
+    struct JobPool {
+        Job* Jobs = nullptr;
+        size_t Cursor = 0;
+
+        ~JobPool() {
+            if (!Jobs) return;
+            for (size_t i = 0; i < JobPoolSize; ++i) {
+                //Jobs of this thread are still running elsewhere, the slots must outlive them.
+                if (Jobs[i].InUse.load(std::memory_order_acquire)) return;
+            }
+            delete[] Jobs;
+        }
+    };
+
+    thread_local JobPool LocalJobs;
+    thread_local int LocalWorkerIndex = -1;
+    thread_local int LocalSlot = -1;
+    thread_local uint32_t LocalRng = 0x9E3779B9u;
+    thread_local uint32_t LocalSearches = 0;
+
+    std::vector<std::unique_ptr<Worker>> Workers;
+    MPMCQueue<Job*, InjectionCapacity> Injection[LaneCount];
+    MPMCQueue<Job*, IOCapacity> IOQueue;
+    Semaphore IOPending;
+    std::atomic<bool> Running{ false };
+    //Parked workers wait on the epoch, submitters bump it when someone sleeps.
+    std::atomic<uint32_t> WakeEpoch{ 0 };
+    std::atomic<uint32_t> Sleepers{ 0 };
+    bool PinThreads = false;
+    int ReservedCpus[3] = { -1, -1, -1 };   // Indexed by ReservedCore.
+
+#ifndef NDEBUG
+    //Calls of threads outside the pool inside Wait, RunPendingJob or GetStats: they read Workers, Shutdown must not free it under them.
+    //The thread calling Shutdown may be one of them (a job run inline by its Wait), it no longer reads the old array afterwards.
+    std::atomic<int> OutsideCalls{ 0 };
+    thread_local int LocalOutsideCalls = 0;
+#endif
+    struct [[maybe_unused]] OutsideCallScope {
+#ifndef NDEBUG
+        const bool Outside = LocalSlot < 0;
+        OutsideCallScope() noexcept {
+            if (!Outside) return;
+            OutsideCalls.fetch_add(1, std::memory_order_relaxed);
+            ++LocalOutsideCalls;
+        }
+        ~OutsideCallScope() {
+            if (!Outside) return;
+            OutsideCalls.fetch_sub(1, std::memory_order_relaxed);
+            --LocalOutsideCalls;
+        }
+#endif
+    };
+
+    //WorkerLocal registry, constant initialised: WorkerLocal statics of other translation units may register before this one is initialised.
+    WorkerLocalBase* Locals = nullptr;
+    SpinLock LocalsLock;
+    unsigned int LocalSlotCount = 1;
+
+    std::atomic<bool> StatsEnabled{ false };
+    StatCounters ExternalStats;
+    ThreadPoolStats LastLoggedStats;
+
+    std::unique_ptr<JobFiber> Fibers[MaxFibers];
+    std::atomic<size_t> FiberCount{ 0 };
+    MPMCQueue<JobFiber*, MaxFibers> FreeFibers;
+    thread_local JobFiber* LocalFiber = nullptr;
+
+    //Fibers migrate between threads, keep the compiler from caching the thread local across a switch.
+    HBR_NOINLINE JobFiber* GetCurrentFiber() noexcept {
+        return LocalFiber;
+    }
+
+    HBR_NOINLINE void SetCurrentFiber(JobFiber* fiber) noexcept {
+        LocalFiber = fiber;
+    }
+
+    inline uint32_t NextRandom() noexcept {
+        //xorshift32, only used to spread steal attempts.
+        uint32_t x = LocalRng;
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        return LocalRng = x;
+    }
+
+    uint64_t NowNanoseconds() noexcept {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    //Never 0, which marks a job submitted without stats.
+    uint32_t SubmitTimestamp() noexcept {
+        return static_cast<uint32_t>(NowNanoseconds() / 1000) | 1u;
+    }
+
+    StatCounters& LocalStats() noexcept {
+        return LocalWorkerIndex >= 0 ? Workers[LocalWorkerIndex]->Stats : ExternalStats;
+    }
+
+    void Bump(std::atomic<uint64_t>& counter, uint64_t n = 1) noexcept {
+        if (LocalWorkerIndex >= 0) counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        else counter.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void RecordSteals(uint64_t attempts, bool stolen) noexcept {
+        if (!StatsEnabled.load(std::memory_order_relaxed) || attempts == 0) return;
+        StatCounters& stats = LocalStats();
+        Bump(stats.StealAttempts, attempts);
+        if (stolen) Bump(stats.Steals);
+    }
+
+    WorkerStats Sample(const StatCounters& counters, uint64_t now) noexcept {
+        WorkerStats stats;
+        stats.JobsRun = counters.JobsRun.load(std::memory_order_relaxed);
+        stats.StealAttempts = counters.StealAttempts.load(std::memory_order_relaxed);
+        stats.Steals = counters.Steals.load(std::memory_order_relaxed);
+        stats.IdleNanoseconds = counters.Idle.Read(now);
+        stats.ParkedNanoseconds = counters.Parked.Read(now);
+        for (size_t b = 0; b < WorkerStats::LatencyBuckets; ++b) stats.Latency[b] = counters.Latency[b].load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    void WakeOne() noexcept {
+        //Pairs with the Sleepers increment in WorkerMain: either the sleeper sees the new job, or we see the sleeper.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (Sleepers.load(std::memory_order_relaxed)) {
+            WakeEpoch.fetch_add(1, std::memory_order_release);
+            WakeEpoch.notify_one();
+        }
+    }
+
+    //IO jobs fall back to the Background lane when the pool has no IO threads.
+    size_t LaneOf(const Job* job) noexcept {
+        return std::min(static_cast<size_t>(job->Priority), BackgroundLane);
+    }
+
+    Job* FindJobInLane(int self, size_t lane) noexcept {
+        if (self >= 0) {
+            if (Job* job = Workers[self]->Deques[lane].Pop()) return job;
+        }
+        Job* job = nullptr;
+        if (Injection[lane].Dequeue(job)) return job;
+
+        const size_t count = Workers.size();
+        if (count == 0) return nullptr;
+        if (self < 0) {
+            const size_t start = NextRandom() % count;
+            for (size_t i = 0; i < count; ++i) {
+                if (Job* stolen = Workers[(start + i) % count]->Deques[lane].Steal()) {
+                    RecordSteals(i + 1, true);
+                    return stolen;
+                }
+            }
+            RecordSteals(count, false);
+            return nullptr;
+        }
+        //Closest tiers first, random start inside a tier so thieves spread out.
+        const Worker& worker = *Workers[self];
+        uint32_t tierBegin = 0;
+        for (uint32_t tierEnd : worker.TierEnds) {
+            const uint32_t size = tierEnd - tierBegin;
+            const uint32_t start = NextRandom() % size;
+            for (uint32_t i = 0; i < size; ++i) {
+                const uint32_t victim = worker.Victims[tierBegin + (start + i) % size];
+                if (Job* stolen = Workers[victim]->Deques[lane].Steal()) {
+                    RecordSteals(tierBegin + i + 1, true);
+                    return stolen;
+                }
+            }
+            tierBegin = tierEnd;
+        }
+        RecordSteals(tierBegin, false);
+        return nullptr;
+    }
+
+    /**
+     * @brief Searches the first lanes (all of them by default) in priority order,
+     * except once every StarvationInterval searches where the lowest lanes go first.
+     */
+    Job* FindJob(int self, size_t lanes = LaneCount) noexcept {
+        if (lanes > 1 && ++LocalSearches % ThreadPool::StarvationInterval == 0) {
+            for (size_t lane = lanes; lane-- > 0;) {
+                if (Job* job = FindJobInLane(self, lane)) return job;
+            }
+            return nullptr;
+        }
+        for (size_t lane = 0; lane < lanes; ++lane) {
+            if (Job* job = FindJobInLane(self, lane)) return job;
+        }
+        return nullptr;
+    }
+}
+
+Job* ThreadPool::AllocateJob() noexcept
+{
+    if (!LocalJobs.Jobs) {
+        LocalJobs.Jobs = new(std::nothrow) Job[JobPoolSize];
+        if (!LocalJobs.Jobs) return nullptr;
+    }
+    for (size_t i = 0; i < JobPoolProbes; ++i) {
+        Job& job = LocalJobs.Jobs[LocalJobs.Cursor++ & (JobPoolSize - 1)];
+        if (!job.InUse.load(std::memory_order_acquire)) {
+            job.InUse.store(true, std::memory_order_relaxed);
+            return &job;
+        }
+    }
+    return nullptr;
+}
+
+void ThreadPool::Submit(Job* job) noexcept
+{
+    job->SubmitTime = StatsEnabled.load(std::memory_order_relaxed) ? SubmitTimestamp() : 0;
+    if (!Running.load(std::memory_order_acquire)) {
+        //No workers to hand the job to.
+        Execute(job);
+        return;
+    }
+    if (job->Priority == JobPriority::IO && IOThreadCount > 0) {
+        if (!IOQueue.Enqueue(job)) {
+            Execute(job);
+            return;
+        }
+        IOPending.Release();
+        return;
+    }
+    const size_t lane = LaneOf(job);
+    const bool queued = LocalWorkerIndex >= 0
+        ? Workers[LocalWorkerIndex]->Deques[lane].Push(job)
+        : Injection[lane].Enqueue(job);
+    if (!queued) {
+        Execute(job);
+        return;
+    }
+    WakeOne();
+}
+
+void ThreadPool::RecordStart(const Job* job) noexcept
+{
+    StatCounters& stats = LocalStats();
+    Bump(stats.JobsRun);
+    if (job->SubmitTime == 0) return;
+    const uint32_t latency = SubmitTimestamp() - job->SubmitTime;
+    const size_t bucket = std::min<size_t>(std::bit_width(latency), WorkerStats::LatencyBuckets - 1);
+    Bump(stats.Latency[bucket]);
+}
+
+void ThreadPool::Execute(Job* job) noexcept
+{
+    if (StatsEnabled.load(std::memory_order_relaxed)) RecordStart(job);
+    switch (job->Type) {
+    case Job::Kind::Resume:
+        //The job lives in the fiber, which may be recycled by the time Run returns.
+        job->Run();
+        return;
+    case Job::Kind::Fiber:
+        if (JobFiber* fiber = AcquireFiber()) {
+            fiber->Task = job;
+            //Resumes go back to the lane the job was queued in.
+            fiber->Resume.Priority = job->Priority;
+            RunFiber(fiber);
+            return;
+        }
+        break;
+    case Job::Kind::Normal:
+        break;
+    }
+    RunJob(job);
+}
+
+void ThreadPool::RunJob(Job* job) noexcept
+{
+    WaitGroup* group = job->Group;
+    job->Run();
+    job->Group = nullptr;
+    job->InUse.store(false, std::memory_order_release);
+    if (group) group->Done();
+}
+
+JobFiber* ThreadPool::AcquireFiber() noexcept
+{
+    JobFiber* fiber = nullptr;
+    if (FreeFibers.Dequeue(fiber)) return fiber;
+
+    const size_t index = FiberCount.fetch_add(1, std::memory_order_relaxed);
+    if (index >= MaxFibers) {
+        FiberCount.fetch_sub(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+    fiber = Fibers[index].get();
+    if (!fiber) {
+        Fibers[index].reset(new(std::nothrow) JobFiber());
+        fiber = Fibers[index].get();
+    }
+    if (!fiber || (!fiber->Context.IsValid() && !fiber->Context.Create(&ThreadPool::FiberMain, fiber))) {
+        //The slot stays reserved, creation is not retried.
+        Logger::Log("ThreadPool: failed to create a job fiber.");
+        return nullptr;
+    }
+
+    fiber->Waiter.Owner = fiber;
+    fiber->Waiter.Resume = [](WaitGroup::Waiter* self) {
+        Submit(&static_cast<JobFiber::ResumeWaiter*>(self)->Owner->Resume);
+    };
+    fiber->Resume.Type = Job::Kind::Resume;
+    fiber->Resume.InUse.store(true, std::memory_order_relaxed);
+    std::memcpy(fiber->Resume.Storage, &fiber, sizeof(fiber));
+    fiber->Resume.Invoke = [](Job& self) {
+        JobFiber* owner;
+        std::memcpy(&owner, self.Storage, sizeof(owner));
+        RunFiber(owner);
+    };
+    return fiber;
+}
+
+void ThreadPool::RunFiber(JobFiber* fiber) noexcept
+{
+    JobFiber* previous = GetCurrentFiber();
+    while (true) {
+        SetCurrentFiber(fiber);
+        fiber->Context.SwitchTo();
+        SetCurrentFiber(previous);
+
+        if (!fiber->Task) {
+            if (!FreeFibers.Enqueue(fiber)) Logger::Log("ThreadPool: fiber pool overflow.");
+            return;
+        }
+        //Suspended in Wait. Registering happens here, on our stack: once registered the fiber may be resumed by another thread right away.
+        WaitGroup* group = std::exchange(fiber->WaitingOn, nullptr);
+        if (group->AddWaiter(&fiber->Waiter)) return;
+        //The group reached zero in the meantime, continue immediately.
+    }
+}
+
+void ThreadPool::FiberMain(void* arg)
+{
+    JobFiber* self = static_cast<JobFiber*>(arg);
+    while (true) {
+        RunJob(self->Task);
+        self->Task = nullptr;
+        self->Context.SwitchBack();
+    }
+}
+
+void ThreadPool::WorkerMain(unsigned int index)
+{
+    LocalWorkerIndex = static_cast<int>(index);
+    LocalSlot = static_cast<int>(index);
+    LocalRng ^= (index + 1) * 0x85EBCA6Bu;
+    if (Workers[index]->Cpu >= 0 && !CpuTopology::Get().PinCurrentThread(static_cast<uint32_t>(Workers[index]->Cpu)))
+        Logger::Log("ThreadPool: could not pin worker {} to cpu {}.", index, Workers[index]->Cpu);
+    StatCounters& stats = Workers[index]->Stats;
+    unsigned int idle = 0;
+    bool counted = false;       // Counted in IdleWorkers.
+    const auto run = [&](Job* job) {
+        if (counted) {
+            IdleWorkers.fetch_sub(1, std::memory_order_relaxed);
+            counted = false;
+            if (stats.Idle.Since.load(std::memory_order_relaxed)) stats.Idle.End(NowNanoseconds());
+        }
+        Execute(job);
+        idle = 0;
+    };
+    while (true) {
+        if (Job* job = FindJob(LocalWorkerIndex)) {
+            run(job);
+            continue;
+        }
+        if (!counted) {
+            IdleWorkers.fetch_add(1, std::memory_order_relaxed);
+            counted = true;
+            if (StatsEnabled.load(std::memory_order_relaxed)) stats.Idle.Begin(NowNanoseconds());
+        }
+        if (!Running.load(std::memory_order_acquire)) break;
+        if (++idle < SpinCount) {
+            CpuRelax();
+            continue;
+        }
+        //Out of work: service the timers before parking.
+        if (TimerWheel::Get().Advance()) {
+            idle = 0;
+            continue;
+        }
+
+        const uint32_t epoch = WakeEpoch.load(std::memory_order_acquire);
+        Sleepers.fetch_add(1, std::memory_order_seq_cst);
+        //Re-check after announcing ourselves, a job queued before the increment would otherwise be missed.
+        if (Job* job = FindJob(LocalWorkerIndex)) {
+            Sleepers.fetch_sub(1, std::memory_order_relaxed);
+            run(job);
+            continue;
+        }
+        if (Running.load(std::memory_order_acquire)) {
+            const bool timed = stats.Idle.Since.load(std::memory_order_relaxed) != 0;
+            if (timed) stats.Parked.Begin(NowNanoseconds());
+            WakeEpoch.wait(epoch, std::memory_order_acquire);
+            if (timed) stats.Parked.End(NowNanoseconds());
+        }
+        Sleepers.fetch_sub(1, std::memory_order_relaxed);
+        idle = 0;
+    }
+    if (counted) IdleWorkers.fetch_sub(1, std::memory_order_relaxed);
+    stats.Idle.End(NowNanoseconds());
+    LocalWorkerIndex = -1;
+    LocalSlot = -1;
+}
+
+void ThreadPool::IOThreadMain(unsigned int index)
+{
+    LocalSlot = static_cast<int>(ThreadCount + index);
+    const int cpu = ReservedCpus[static_cast<size_t>(ReservedCore::IO)];
+    if (PinThreads && cpu >= 0) CpuTopology::Get().PinCurrentThread(static_cast<uint32_t>(cpu));
+    while (true) {
+        IOPending.Acquire();
+        Job* job = nullptr;
+        if (IOQueue.Dequeue(job)) {
+            Execute(job);
+            continue;
+        }
+        //A token without a job is the shutdown signal.
+        if (!Running.load(std::memory_order_acquire)) break;
+    }
+}
+
+void ThreadPool::InitalizePool(unsigned int threadCount, const ThreadPoolConfig& config)
+{
+    if (Running.load(std::memory_order_acquire)) {
+        Logger::Log("ThreadPool already initialized.");
+        return;
+    }
+    const CpuTopology& topology = CpuTopology::Get();
+    PinThreads = config.PinThreads && topology.IsDetected();
+
+    //Reserved threads take the first cores of the spread order, workers the logical CPUs after them.
+    const std::vector<uint32_t> order = topology.GetSpreadOrder();
+    const bool reserve[3] = { config.ReserveMainCore, config.ReserveRenderCore, config.ReserveIOCore };
+    size_t next = 0;
+    for (size_t role = 0; role < 3; ++role) {
+        ReservedCpus[role] = reserve[role] && next < order.size() ? static_cast<int>(order[next++]) : -1;
+    }
+    ThreadCount = std::min<unsigned int>(threadCount, static_cast<unsigned int>(order.size() - next));
+    IOThreadCount = config.IOThreadCount;
+    Logger::Log("{} Threads Allocated", ThreadCount);
+    if (IOThreadCount > 0) Logger::Log("{} IO Threads Allocated", IOThreadCount);
+
+    {
+        //No thread of the pool is running, nothing reads the slots.
+        std::lock_guard<SpinLock> lock(LocalsLock);
+        LocalSlotCount = ThreadCount + IOThreadCount + 1;
+        for (WorkerLocalBase* local = Locals; local; local = local->m_next) local->Allocate(LocalSlotCount);
+    }
+
+    Workers.clear();
+    for (unsigned int i = 0; i < ThreadCount; i++) {
+        auto worker = std::make_unique<Worker>();
+        if (PinThreads) worker->Cpu = static_cast<int>(order[next + i]);
+        Workers.push_back(std::move(worker));
+    }
+    for (unsigned int i = 0; i < ThreadCount; i++) {
+        Worker& worker = *Workers[i];
+        for (unsigned int v = 0; v < ThreadCount; v++) {
+            if (v != i) worker.Victims.push_back(v);
+        }
+        if (worker.Victims.empty()) continue;
+        if (!PinThreads) {
+            worker.TierEnds.push_back(static_cast<uint32_t>(worker.Victims.size()));
+            continue;
+        }
+        const auto distance = [&](uint32_t v) {
+            return topology.GetDistance(static_cast<uint32_t>(worker.Cpu), static_cast<uint32_t>(Workers[v]->Cpu));
+        };
+        std::stable_sort(worker.Victims.begin(), worker.Victims.end(), [&](uint32_t a, uint32_t b) { return distance(a) < distance(b); });
+        for (size_t v = 1; v <= worker.Victims.size(); ++v) {
+            if (v == worker.Victims.size() || distance(worker.Victims[v]) != distance(worker.Victims[v - 1]))
+                worker.TierEnds.push_back(static_cast<uint32_t>(v));
+        }
+    }
+
+    Running.store(true, std::memory_order_release);
+    for (unsigned int i = 0; i < ThreadCount; i++) {
+        Threads.emplace_back(&ThreadPool::WorkerMain, i);
+    }
+    for (unsigned int i = 0; i < IOThreadCount; i++) {
+        IOThreads.emplace_back(&ThreadPool::IOThreadMain, i);
+    }
+}
+
+bool ThreadPool::PinToReservedCore(ReservedCore role)
+{
+    const int cpu = ReservedCpus[static_cast<size_t>(role)];
+    if (!PinThreads || cpu < 0) return false;
+    return CpuTopology::Get().PinCurrentThread(static_cast<uint32_t>(cpu));
+}
+
+void ThreadPool::Shutdown()
+{
+    if (!Running.exchange(false, std::memory_order_acq_rel)) return;
+    assert(OutsideCalls.load(std::memory_order_relaxed) == LocalOutsideCalls && "ThreadPool shut down while a thread outside the pool is using it.");
+    WakeEpoch.fetch_add(1, std::memory_order_release);
+    WakeEpoch.notify_all();
+    for (auto& thread : Threads) {
+        thread.join();
+    }
+    Threads.clear();
+    IOPending.Release(static_cast<int32_t>(IOThreadCount));
+    for (auto& thread : IOThreads) {
+        thread.join();
+    }
+    IOThreads.clear();
+    IOThreadCount = 0;
+    //Jobs queued from outside the pool after the threads drained it.
+    Job* job = nullptr;
+    while (IOQueue.Dequeue(job)) Execute(job);
+    for (auto& lane : Injection) {
+        while (lane.Dequeue(job)) Execute(job);
+    }
+    //Leftover tokens of the jobs run above.
+    while (IOPending.TryAcquire()) {}
+    Workers.clear();
+    ThreadCount = 0;
+
+    //Only idle fibers can be released, a fiber still suspended on a WaitGroup owns its stack until resumed.
+    JobFiber* fiber = nullptr;
+    size_t released = 0;
+    while (FreeFibers.Dequeue(fiber)) {
+        for (auto& slot : Fibers) {
+            if (slot.get() == fiber) {
+                slot.reset();
+                break;
+            }
+        }
+        ++released;
+    }
+    const size_t created = FiberCount.load(std::memory_order_relaxed);
+    if (released == created) FiberCount.store(0, std::memory_order_relaxed);
+    else Logger::Log("ThreadPool: {} fiber jobs still suspended at shutdown.", created - released);
+}
+
+void ThreadPool::Wait(WaitGroup& wg)
+{
+    //A fiber inside an Rcu read section stays on this thread: its guard is thread-local, it must be released where it was taken.
+    JobFiber* fiber = GetCurrentFiber();
+    if (fiber && !Rcu::IsReading()) {
+        if (wg.IsDone()) return;
+        //RunFiber registers us on the group once we are off this stack.
+        fiber->WaitingOn = &wg;
+        fiber->Context.SwitchBack();
+        return;
+    }
+
+    //Out of work, the thread parks with the idle workers: woken by the next queued job, or by the last Done through this waiter.
+    struct WakeWaiter : WaitGroup::Waiter {
+        std::atomic<bool> Fired{ false };
+    } waiter;
+    waiter.Resume = [](WaitGroup::Waiter* self) {
+        //The node may be gone as soon as Fired is set.
+        static_cast<WakeWaiter*>(self)->Fired.store(true, std::memory_order_release);
+        //Every sleeper: a single wake could go to a worker instead.
+        WakeEpoch.fetch_add(1, std::memory_order_release);
+        WakeEpoch.notify_all();
+    };
+    bool registered = false;
+
+    const OutsideCallScope scope;
+    unsigned int idle = 0;
+    while (!wg.IsDone()) {
+        //Background jobs only once nothing else turned up, they may be what we are waiting for.
+        if (Job* job = FindJob(LocalWorkerIndex, idle < SpinCount ? BackgroundLane : LaneCount)) {
+            Execute(job);
+            idle = 0;
+            continue;
+        }
+        if (++idle < SpinCount) {
+            CpuRelax();
+            continue;
+        }
+        if (!registered) {
+            if (!wg.AddWaiter(&waiter)) return;
+            registered = true;
+        }
+        const uint32_t epoch = WakeEpoch.load(std::memory_order_acquire);
+        Sleepers.fetch_add(1, std::memory_order_seq_cst);
+        //Re-check after announcing ourselves, like WorkerMain.
+        if (Job* job = FindJob(LocalWorkerIndex)) {
+            Sleepers.fetch_sub(1, std::memory_order_relaxed);
+            Execute(job);
+            idle = 0;
+            continue;
+        }
+        if (!waiter.Fired.load(std::memory_order_acquire)) WakeEpoch.wait(epoch, std::memory_order_acquire);
+        Sleepers.fetch_sub(1, std::memory_order_relaxed);
+        idle = 0;
+    }
+    //The counter reaches zero just before the waiters are resumed: the node must outlive the call.
+    if (registered) {
+        while (!waiter.Fired.load(std::memory_order_acquire)) CpuRelax();
+    }
+}
+
+bool ThreadPool::RunPendingJob()
+{
+    const OutsideCallScope scope;
+    if (Job* job = FindJob(LocalWorkerIndex)) {
+        Execute(job);
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::EnableStats(bool enable) noexcept
+{
+    StatsEnabled.store(enable, std::memory_order_relaxed);
+}
+
+bool ThreadPool::IsStatsEnabled() noexcept
+{
+    return StatsEnabled.load(std::memory_order_relaxed);
+}
+
+ThreadPoolStats ThreadPool::GetStats()
+{
+    const OutsideCallScope scope;
+    ThreadPoolStats stats;
+    stats.TimeNanoseconds = NowNanoseconds();
+    stats.Workers.reserve(Workers.size());
+    for (const auto& worker : Workers) {
+        WorkerStats sample = Sample(worker->Stats, stats.TimeNanoseconds);
+        for (const auto& deque : worker->Deques) sample.QueuedJobs += deque.Size();
+        stats.Workers.push_back(sample);
+    }
+    stats.External = Sample(ExternalStats, stats.TimeNanoseconds);
+    for (const auto& lane : Injection) stats.InjectedJobs += lane.Size();
+    stats.IOQueuedJobs = IOQueue.Size();
+    return stats;
+}
+
+void ThreadPool::LogStats()
+{
+    ThreadPoolStats stats = GetStats();
+    const ThreadPoolStats& last = LastLoggedStats;
+    //The first call, or the pool was restarted: report from the start.
+    const bool fresh = last.Workers.size() != stats.Workers.size();
+    const uint64_t elapsed = fresh || last.TimeNanoseconds == 0 ? 0 : stats.TimeNanoseconds - last.TimeNanoseconds;
+
+    WorkerStats total;
+    for (size_t i = 0; i < stats.Workers.size(); ++i) {
+        WorkerStats delta = stats.Workers[i];
+        if (!fresh) delta -= last.Workers[i];
+        total += delta;
+        const double idle = elapsed ? 100.0 * static_cast<double>(delta.IdleNanoseconds) / static_cast<double>(elapsed) : 0.0;
+        Logger::Log("Worker {}: {} jobs, {}/{} steals, {:.1f}% idle, {} queued, latency p50 <{}us p99 <{}us",
+            i, delta.JobsRun, delta.Steals, delta.StealAttempts, idle, delta.QueuedJobs,
+            delta.GetLatencyPercentile(0.5), delta.GetLatencyPercentile(0.99));
+    }
+    WorkerStats external = stats.External;
+    if (!fresh) external -= last.External;
+    total += external;
+    Logger::Log("ThreadPool: {} jobs ({} outside the pool) over {:.2f}ms, {} injected, {} IO queued, latency p50 <{}us p99 <{}us",
+        total.JobsRun, external.JobsRun, static_cast<double>(elapsed) / 1e6, stats.InjectedJobs, stats.IOQueuedJobs,
+        total.GetLatencyPercentile(0.5), total.GetLatencyPercentile(0.99));
+    LastLoggedStats = std::move(stats);
+}
+
+int ThreadPool::GetWorkerIndex() noexcept
+{
+    return LocalWorkerIndex;
+}
+
+unsigned int ThreadPool::GetLocalSlot() noexcept
+{
+    return LocalSlot >= 0 ? static_cast<unsigned int>(LocalSlot) : LocalSlotCount - 1;
+}
+
+unsigned int ThreadPool::GetLocalSlotCount() noexcept
+{
+    return LocalSlotCount;
+}
+
+void WorkerLocalBase::Register()
+{
+    std::lock_guard<SpinLock> lock(LocalsLock);
+    m_next = Locals;
+    if (Locals) Locals->m_prev = this;
+    Locals = this;
+    Allocate(LocalSlotCount);
+}
+
+void WorkerLocalBase::Unregister()
+{
+    std::lock_guard<SpinLock> lock(LocalsLock);
+    if (m_prev) m_prev->m_next = m_next;
+    else Locals = m_next;
+    if (m_next) m_next->m_prev = m_prev;
+    m_prev = m_next = nullptr;
+}
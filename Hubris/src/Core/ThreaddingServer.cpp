@@ -0,0 +1,93 @@
+#include "pch.h"
+#include "Core/ThreaddingServer.h"
+#include "Core/MainThreadQueue.h"
+
+using namespace Hubris;
+using namespace Hubris::Core;
+
+void ThreadPoolBackend::Start(unsigned int workerCount, const ThreadPoolConfig& config)
+{
+    ThreadPool::InitalizePool(workerCount, config);
+}
+
+void ThreadPoolBackend::Stop()
+{
+    ThreadPool::Shutdown();
+}
+
+void ThreaddingServer::SelectBackend(unsigned int Tcount)
+{
+    if (CustomBackend) return;
+    if (Tcount == 0) {
+        if (!dynamic_cast<DeterministicBackend*>(Backend.get())) Backend = std::make_unique<DeterministicBackend>();
+    }
+    else if (!dynamic_cast<ThreadPoolBackend*>(Backend.get())) {
+        Backend = std::make_unique<ThreadPoolBackend>();
+    }
+}
+
+void ThreaddingServer::Quiesce()
+{
+    if (Pipeline) Pipeline->Flush();
+    MainThreadQueue::Drain();
+}
+
+void ThreaddingServer::Initialize(unsigned int Tcount, const ThreadPoolConfig& config, FramePipeline* pipeline)
+{
+    if (Running) {
+        Logger::Log("ThreaddingServer already initialized.");
+        return;
+    }
+    Config = config;
+    Pipeline = pipeline;
+    SelectBackend(Tcount);
+    Backend->Start(Tcount, Config);
+    ThreadPool::PinToReservedCore(ReservedCore::Main);
+    Running = true;
+    Logger::Log("Threading backend: {}, {} workers", Backend->GetName(), Backend->GetWorkerCount());
+}
+
+void ThreaddingServer::Shutdown()
+{
+    if (!Running) return;
+    Quiesce();
+    Backend->Stop();
+    //Posted by the last jobs.
+    MainThreadQueue::Drain();
+    Running = false;
+}
+
+bool ThreaddingServer::Resize(unsigned int Tcount)
+{
+    if (!Running) return false;
+    //Restarting the threads from here could pull the pool from under the caller (a job, a handler, a drain in progress).
+    RequestedCount.store(Tcount, std::memory_order_release);
+    return true;
+}
+
+void ThreaddingServer::ApplyResize()
+{
+    if (!Running || !MainThreadQueue::IsMainThread()) return;
+    const unsigned int Tcount = RequestedCount.exchange(NoResize, std::memory_order_acq_rel);
+    if (Tcount == NoResize || Tcount == Backend->GetWorkerCount()) return;
+    Quiesce();
+    Backend->Stop();
+    SelectBackend(Tcount);
+    Backend->Start(Tcount, Config);
+    Logger::Log("Threading backend: {}, resized to {} workers", Backend->GetName(), Backend->GetWorkerCount());
+}
+
+void ThreaddingServer::SetBackend(std::unique_ptr<ThreadingBackend> backend)
+{
+    if (!backend) return;
+    CustomBackend = true;
+    if (!Running) {
+        Backend = std::move(backend);
+        return;
+    }
+    const unsigned int workers = Backend->GetWorkerCount();
+    Quiesce();
+    Backend->Stop();
+    Backend = std::move(backend);
+    Backend->Start(workers, Config);
+}
@@ -0,0 +1,167 @@
+#include "pch.h"
+#include "Core/TimerWheel.h"
+#include <bit>
+
+using namespace Hubris;
+
+TimerWheel::TimerWheel(Clock::duration resolution)
+    : m_origin(Clock::now()), m_resolution(resolution > Clock::duration::zero() ? resolution : Clock::duration(1))
+{
+    std::fill(std::begin(m_slots), std::end(m_slots), Null);
+}
+
+TimerWheel& TimerWheel::Get()
+{
+    static TimerWheel wheel;
+    return wheel;
+}
+
+uint64_t TimerWheel::ToTicks(Clock::duration duration) const noexcept
+{
+    if (duration <= Clock::duration::zero()) return 0;
+    return static_cast<uint64_t>(duration / m_resolution);
+}
+
+void TimerWheel::Link(uint32_t index) noexcept
+{
+    Timer& timer = m_timers[index];
+    //A deadline already reached (scheduled from the past, or a periodic timer behind) fires on the next tick.
+    const uint64_t deadline = std::max(timer.Deadline, m_current + 1);
+    //The highest byte where the deadline differs from now picks the wheel: that slot is reached (and cascaded down) exactly when the byte rolls over.
+    const uint64_t diff = deadline ^ m_current;
+    uint32_t level = static_cast<uint32_t>(63 - std::countl_zero(diff)) / SlotBits;
+    uint32_t slot;
+    if (level < Levels) {
+        slot = static_cast<uint32_t>(deadline >> (level * SlotBits)) & SlotMask;
+    }
+    else {
+        //Beyond the last wheel: park in the slot reached last, it is placed again when cascaded.
+        level = Levels - 1;
+        slot = static_cast<uint32_t>((m_current >> (level * SlotBits)) + SlotMask) & SlotMask;
+    }
+    uint32_t& head = m_slots[level * SlotCount + slot];
+    timer.Slot = static_cast<uint16_t>(level * SlotCount + slot);
+    timer.Prev = Null;
+    timer.Next = head;
+    if (head != Null) m_timers[head].Prev = index;
+    head = index;
+}
+
+void TimerWheel::Unlink(uint32_t index) noexcept
+{
+    Timer& timer = m_timers[index];
+    if (timer.Prev != Null) m_timers[timer.Prev].Next = timer.Next;
+    else m_slots[timer.Slot] = timer.Next;
+    if (timer.Next != Null) m_timers[timer.Next].Prev = timer.Prev;
+    timer.Prev = timer.Next = Null;
+}
+
+void TimerWheel::Release(uint32_t index) noexcept
+{
+    Timer& timer = m_timers[index];
+    timer.Callback.reset();
+    timer.Active = false;
+    ++timer.Generation;
+    timer.Next = m_freeList;
+    m_freeList = index;
+    --m_activeCount;
+}
+
+void TimerWheel::Expire(uint32_t index)
+{
+    Timer& timer = m_timers[index];
+    m_due.push_back(Due{ timer.Callback, timer.Priority });
+    if (timer.Period) {
+        timer.Deadline += timer.Period;
+        Link(index);
+    }
+    else {
+        Release(index);
+    }
+}
+
+void TimerWheel::Cascade(uint32_t level, uint32_t slot)
+{
+    uint32_t index = std::exchange(m_slots[level * SlotCount + slot], Null);
+    while (index != Null) {
+        const uint32_t next = m_timers[index].Next;
+        //Due on the tick being processed (its lower bytes are zero): firing now, Link would defer it to the next tick.
+        if (m_timers[index].Deadline <= m_current) Expire(index);
+        else Link(index);
+        index = next;
+    }
+}
+
+TimerWheel::TimerId TimerWheel::Insert(Clock::duration delay, Clock::duration period, std::shared_ptr<std::function<void()>> callback, JobPriority priority)
+{
+    //Rounded up: a timer never fires early.
+    const uint64_t deadline = ToTicks(Clock::now() - m_origin + delay + m_resolution - Clock::duration(1));
+    std::lock_guard<SpinLock> lock(m_lock);
+    uint32_t index = m_freeList;
+    if (index != Null) {
+        m_freeList = m_timers[index].Next;
+    }
+    else {
+        index = static_cast<uint32_t>(m_timers.size());
+        m_timers.emplace_back();
+    }
+    Timer& timer = m_timers[index];
+    timer.Callback = std::move(callback);
+    timer.Deadline = deadline;
+    timer.Period = period > Clock::duration::zero() ? std::max<uint64_t>(ToTicks(period), 1) : 0;
+    timer.Priority = priority;
+    timer.Active = true;
+    ++m_activeCount;
+    Link(index);
+    return TimerId{ index, timer.Generation };
+}
+
+bool TimerWheel::Cancel(TimerId id)
+{
+    std::lock_guard<SpinLock> lock(m_lock);
+    if (id.Index >= m_timers.size()) return false;
+    Timer& timer = m_timers[id.Index];
+    if (!timer.Active || timer.Generation != id.Generation) return false;
+    Unlink(id.Index);
+    Release(id.Index);
+    return true;
+}
+
+size_t TimerWheel::Advance(Clock::time_point now)
+{
+    if (m_advancing.exchange(true, std::memory_order_acquire)) return 0;
+    {
+        std::lock_guard<SpinLock> lock(m_lock);
+        const uint64_t target = ToTicks(now - m_origin);
+        if (m_activeCount == 0 && target > m_current) m_current = target;
+        while (m_current < target) {
+            ++m_current;
+            //Higher wheels first: a cascade from level 2 may fill the level 1 slot cascaded next.
+            uint32_t top = 0;
+            while (top + 1 < Levels && (m_current & ((uint64_t(1) << ((top + 1) * SlotBits)) - 1)) == 0) ++top;
+            for (uint32_t level = top; level > 0; --level)
+                Cascade(level, static_cast<uint32_t>(m_current >> (level * SlotBits)) & SlotMask);
+
+            uint32_t index = std::exchange(m_slots[m_current & SlotMask], Null);
+            while (index != Null) {
+                const uint32_t next = m_timers[index].Next;
+                Expire(index);
+                index = next;
+            }
+            if (m_activeCount == 0) m_current = target;
+        }
+    }
+    //Queued outside the lock: a full pool runs jobs inline, and callbacks may schedule timers.
+    const size_t queued = m_due.size();
+    for (Due& due : m_due)
+        ThreadPool::QueueJob(due.Priority, nullptr, [callback = std::move(due.Callback)] { (*callback)(); });
+    m_due.clear();
+    m_advancing.store(false, std::memory_order_release);
+    return queued;
+}
+
+size_t TimerWheel::GetTimerCount()
+{
+    std::lock_guard<SpinLock> lock(m_lock);
+    return m_activeCount;
+}